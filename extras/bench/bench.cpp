@@ -0,0 +1,364 @@
+/*
+ * Microbenchmarks for the packet parser, the telemetry serializer and the byteutils codecs.
+ * Build and run with PlatformIO: pio run -e native_bench && .pio/build/native_bench/program [label]
+ * Prints one JSON object per line, for example:
+ * {"label":"0.3.1","bench":"parse/nou3_command","ns_per_op":85.2,"ns_per_op_min":83.9,"allocs_per_op":0,"bytes_per_op":45,"iterations":1048576}
+ * The optional label is copied into every line so results from different library versions can be compared.
+ */
+
+#include <xrp-style-wpilib-comms.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+// count heap allocations made by the code being measured
+static unsigned long allocationCount = 0;
+
+void* operator new(size_t size)
+{
+    allocationCount++;
+    void* ptr = malloc(size ? size : 1);
+    if (ptr == nullptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+void operator delete(void* ptr) noexcept
+{
+    free(ptr);
+}
+void operator delete(void* ptr, size_t) noexcept
+{
+    free(ptr);
+}
+
+// stop the compiler from optimizing away work whose result isn't used
+template <typename T>
+static inline void doNotOptimize(T& value)
+{
+    asm volatile("" : : "g"(&value) : "memory");
+}
+
+static const char* label = "";
+
+/**
+ * @brief  run fn in a loop, calibrating the number of iterations so each repetition takes at least 50ms, and print the results
+ * @param  bytesPerOp: size of the packet or value processed per call, reported for computing throughput
+ */
+template <typename Fn>
+static void bench(const char* name, int bytesPerOp, Fn fn)
+{
+    using clock = std::chrono::steady_clock;
+    const int REPETITIONS = 7;
+    unsigned long iterations = 1024;
+    while (true) {
+        clock::time_point start = clock::now();
+        for (unsigned long i = 0; i < iterations; i++) {
+            fn();
+        }
+        if (clock::now() - start > std::chrono::milliseconds(50) || iterations > (1UL << 30)) {
+            break;
+        }
+        iterations *= 2;
+    }
+    std::vector<double> nsPerOp;
+    unsigned long allocations = 0;
+    for (int r = 0; r < REPETITIONS; r++) {
+        unsigned long allocationsBefore = allocationCount;
+        clock::time_point start = clock::now();
+        for (unsigned long i = 0; i < iterations; i++) {
+            fn();
+        }
+        clock::time_point end = clock::now();
+        allocations += allocationCount - allocationsBefore;
+        nsPerOp.push_back(std::chrono::duration<double, std::nano>(end - start).count() / iterations);
+    }
+    std::sort(nsPerOp.begin(), nsPerOp.end());
+    printf("{\"label\":\"%s\",\"bench\":\"%s\",\"ns_per_op\":%.2f,\"ns_per_op_min\":%.2f,\"allocs_per_op\":%.3f,\"bytes_per_op\":%d,\"iterations\":%lu}\n",
+        label, name, nsPerOp[REPETITIONS / 2], nsPerOp[0], (double)allocations / (iterations * REPETITIONS), bytesPerOp, iterations);
+    fflush(stdout);
+}
+
+// gives the benchmarks access to the protected parts of XSWC
+class BenchXSWC : public XSWC {
+public:
+    using XSWC::ParseResult;
+    using XSWC::clearBufferToSend;
+    using XSWC::processMessagesIntoBufferToSend;
+    using XSWC::processReceivedBufferIntoMessages;
+    using XSWC::sendData;
+};
+
+/**
+ * @brief  builds packets in the format sent by wpilib's halsim_xrp
+ */
+class PacketBuilder {
+public:
+    PacketBuilder()
+    {
+        data.resize(3);
+        data[2] = 1; // enabled
+    }
+    void floatBlock(uint8_t tag, uint8_t id, float value)
+    {
+        size_t pos = data.size();
+        data.resize(pos + 7);
+        data[pos] = 6;
+        data[pos + 1] = tag;
+        data[pos + 2] = id;
+        floatToNetwork(value, data.data(), pos + 3);
+    }
+    void dioBlock(uint8_t id, bool value)
+    {
+        data.insert(data.end(), { 3, XRP_TAG_DIO, (char)id, (char)value });
+    }
+    std::vector<char> data;
+};
+
+// the sequence number is incremented every time so the parser doesn't discard the packet as a duplicate
+static void benchParse(const char* name, std::vector<char> packet)
+{
+    BenchXSWC parser;
+    uint16_t sequence = 0;
+    bench(name, packet.size(), [&]() {
+        uint16ToNetwork(sequence++, packet.data(), 0);
+        BenchXSWC::ParseResult result = parser.processReceivedBufferIntoMessages(packet.data(), packet.size());
+        doNotOptimize(result);
+    });
+}
+
+static void benchParsePackets()
+{
+    // the six actuators used by the nou3-xrp example
+    PacketBuilder nou3;
+    for (int id = 0; id < 4; id++) {
+        nou3.floatBlock(XRP_TAG_MOTOR, id, 0.25f * id);
+    }
+    nou3.floatBlock(XRP_TAG_SERVO, 4, 0.5f);
+    nou3.floatBlock(XRP_TAG_SERVO, 5, 0.75f);
+    benchParse("parse/nou3_command", nou3.data);
+
+    // as many blocks as fit in UDP_PACKET_MAX_SIZE_XRP, cycling through every type that can be received
+    PacketBuilder full;
+    for (int i = 0; full.data.size() + 7 <= UDP_PACKET_MAX_SIZE_XRP; i++) {
+        uint8_t id = i % XSWC_MAX_CHANNELS_PER_TAG;
+        switch (i % 4) {
+        case 0:
+            full.floatBlock(XRP_TAG_MOTOR, id, 0.1f * i);
+            break;
+        case 1:
+            full.floatBlock(XRP_TAG_SERVO, id, 0.1f * i);
+            break;
+        case 2:
+            full.floatBlock(XRP_TAG_ANALOG, id, 0.1f * i);
+            break;
+        case 3:
+            full.dioBlock(id, i & 1);
+            break;
+        }
+    }
+    benchParse("parse/max_size_command", full.data);
+
+    // the smallest possible blocks (a size byte of 1 and a tag), filling a whole packet
+    PacketBuilder tiny;
+    while (tiny.data.size() + 2 <= UDP_PACKET_MAX_SIZE_XRP) {
+        tiny.data.insert(tiny.data.end(), { 1, XRP_TAG_MOTOR });
+    }
+    benchParse("parse/min_blocks_known_tag", tiny.data);
+
+    PacketBuilder tinyUnknown;
+    while (tinyUnknown.data.size() + 2 <= UDP_PACKET_MAX_SIZE_XRP) {
+        tinyUnknown.data.insert(tinyUnknown.data.end(), { 1, (char)0x7f });
+    }
+    benchParse("parse/min_blocks_unknown_tag", tinyUnknown.data);
+
+    PacketBuilder headerOnly;
+    benchParse("parse/header_only", headerOnly.data);
+}
+
+static void benchSerialize()
+{
+    BenchXSWC xswc;
+    xrp_gyro_t gyro = { { 0.1f, 0.2f, 0.3f }, { 1.0f, 2.0f, 3.0f } };
+    xrp_accel_t accel = { { 0.0f, 0.0f, 9.8f } };
+    int frameSize = 0;
+
+    // the telemetry sent by the nou3-xrp example's collectDataToSend()
+    auto nou3Telemetry = [&]() {
+        xswc.sendValue_xrp_analog(0, 7.4f);
+        xswc.sendValue_xrp_dio(0, true);
+        xswc.sendData_xrp_accel(accel);
+        xswc.sendData_xrp_gyro(gyro);
+        for (int id = 0; id < 4; id++) {
+            xswc.sendValue_xrp_encoder(id, 1000 * id, 0, 1);
+        }
+        frameSize = xswc.processMessagesIntoBufferToSend();
+        doNotOptimize(frameSize);
+        xswc.clearBufferToSend();
+    };
+    nou3Telemetry();
+    bench("serialize/nou3_telemetry", frameSize, nou3Telemetry);
+
+    // fill a whole datagram with encoder blocks
+    auto maxSizeTelemetry = [&]() {
+        for (int id = 0; id < (UDP_PACKET_MAX_SIZE_XRP - 3) / codec<xrp_encoder_t>::blockSize; id++) {
+            xswc.sendValue_xrp_encoder(id, id, 0, 1);
+        }
+        frameSize = xswc.processMessagesIntoBufferToSend();
+        doNotOptimize(frameSize);
+        xswc.clearBufferToSend();
+    };
+    maxSizeTelemetry();
+    bench("serialize/max_size_encoders", frameSize, maxSizeTelemetry);
+
+    // the same value sent repeatedly, which replaces the existing block
+    bench("serialize/repeated_analog", 7, [&]() {
+        xswc.sendValue_xrp_analog(0, 7.4f);
+    });
+    xswc.clearBufferToSend();
+}
+
+// compare the generated codecs with the MessageType classes
+static void benchCodecs()
+{
+    char buf[64] = { 6, XRP_TAG_MOTOR, 2, 0x3f, 0x00, 0x00, 0x00 };
+    xrp_motor_t motor;
+    bench("codec/registry_motor_decode", 7, [&]() {
+        int n = codec<xrp_motor_t>::decode(motor, buf, 1, sizeof(buf));
+        doNotOptimize(n);
+        doNotOptimize(motor);
+    });
+    XrpMotor motorMessage;
+    MessageType* motorVirtual = &motorMessage;
+    doNotOptimize(motorVirtual);
+    bench("codec/messagetype_motor_decode", 7, [&]() {
+        int n = motorVirtual->fromNetworkBuffer(buf, 1, sizeof(buf));
+        doNotOptimize(n);
+    });
+
+    xrp_gyro_t gyro = { { 0.1f, 0.2f, 0.3f }, { 1.0f, 2.0f, 3.0f } };
+    bench("codec/registry_gyro_encode", 26, [&]() {
+        int n = codec<xrp_gyro_t>::encode(gyro, buf, 0, sizeof(buf));
+        doNotOptimize(n);
+        doNotOptimize(buf);
+    });
+    XrpGyro gyroMessage;
+    gyroMessage.setData(&gyro);
+    MessageType* gyroVirtual = &gyroMessage;
+    doNotOptimize(gyroVirtual);
+    bench("codec/messagetype_gyro_encode", 26, [&]() {
+        int n = gyroVirtual->toNetworkBuffer(buf, 0, sizeof(buf));
+        doNotOptimize(n);
+        doNotOptimize(buf);
+    });
+}
+
+// each byteutils function over a buffer of 256 values
+static void benchByteutils()
+{
+    const int COUNT = 256;
+    static char buf[COUNT * 4];
+    for (int i = 0; i < COUNT * 4; i++) {
+        buf[i] = (char)(i * 37);
+    }
+    float f = 0;
+    int32_t i32 = 0;
+    uint32_t u32 = 0;
+    int16_t i16 = 0;
+    uint16_t u16 = 0;
+
+    bench("byteutils/networkToFloat", 4 * COUNT, [&]() {
+        for (int i = 0; i < COUNT; i++) {
+            f += networkToFloat(buf, i * 4);
+        }
+        doNotOptimize(f);
+    });
+    bench("byteutils/networkToInt32", 4 * COUNT, [&]() {
+        for (int i = 0; i < COUNT; i++) {
+            i32 += networkToInt32(buf, i * 4);
+        }
+        doNotOptimize(i32);
+    });
+    bench("byteutils/networkToUInt32", 4 * COUNT, [&]() {
+        for (int i = 0; i < COUNT; i++) {
+            u32 += networkToUInt32(buf, i * 4);
+        }
+        doNotOptimize(u32);
+    });
+    bench("byteutils/networkToInt16", 2 * COUNT, [&]() {
+        for (int i = 0; i < COUNT; i++) {
+            i16 += networkToInt16(buf, i * 2);
+        }
+        doNotOptimize(i16);
+    });
+    bench("byteutils/networkToUInt16", 2 * COUNT, [&]() {
+        for (int i = 0; i < COUNT; i++) {
+            u16 += networkToUInt16(buf, i * 2);
+        }
+        doNotOptimize(u16);
+    });
+    bench("byteutils/floatToNetwork", 4 * COUNT, [&]() {
+        for (int i = 0; i < COUNT; i++) {
+            floatToNetwork(i * 0.5f, buf, i * 4);
+        }
+        doNotOptimize(buf);
+    });
+    bench("byteutils/int32ToNetwork", 4 * COUNT, [&]() {
+        for (int i = 0; i < COUNT; i++) {
+            int32ToNetwork(i * 1000, buf, i * 4);
+        }
+        doNotOptimize(buf);
+    });
+    bench("byteutils/uint32ToNetwork", 4 * COUNT, [&]() {
+        for (int i = 0; i < COUNT; i++) {
+            uint32ToNetwork(i * 1000u, buf, i * 4);
+        }
+        doNotOptimize(buf);
+    });
+    bench("byteutils/int16ToNetwork", 2 * COUNT, [&]() {
+        for (int i = 0; i < COUNT; i++) {
+            int16ToNetwork(i, buf, i * 2);
+        }
+        doNotOptimize(buf);
+    });
+    bench("byteutils/uint16ToNetwork", 2 * COUNT, [&]() {
+        for (int i = 0; i < COUNT; i++) {
+            uint16ToNetwork(i, buf, i * 2);
+        }
+        doNotOptimize(buf);
+    });
+
+    static float floats[COUNT];
+    static int32_t int32s[COUNT];
+    bench("byteutils/networkToFloats", 4 * COUNT, [&]() {
+        networkToFloats(floats, COUNT, buf);
+        doNotOptimize(floats);
+    });
+    bench("byteutils/floatsToNetwork", 4 * COUNT, [&]() {
+        floatsToNetwork(floats, COUNT, buf);
+        doNotOptimize(buf);
+    });
+    bench("byteutils/networkToInt32s", 4 * COUNT, [&]() {
+        networkToInt32s(int32s, COUNT, buf);
+        doNotOptimize(int32s);
+    });
+    bench("byteutils/int32sToNetwork", 4 * COUNT, [&]() {
+        int32sToNetwork(int32s, COUNT, buf);
+        doNotOptimize(buf);
+    });
+}
+
+int main(int argc, char** argv)
+{
+    if (argc > 1) {
+        label = argv[1];
+    }
+    benchParsePackets();
+    benchSerialize();
+    benchCodecs();
+    benchByteutils();
+    return 0;
+}
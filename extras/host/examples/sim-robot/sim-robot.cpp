@@ -0,0 +1,53 @@
+/*
+ * Runs xrp-style-wpilib-comms on a computer, acting like an XRP robot with simulated motors and encoders.
+ * Point a wpilib XRP simulation at 127.0.0.1 (port 3540) to drive it.
+ * Build and run it with PlatformIO: pio run -e native && .pio/build/native/program
+ * The binary can be run under perf, valgrind or gdb like any other Linux program.
+ */
+
+#include <xrp-style-wpilib-comms.h>
+
+const int NUM_MOTORS = 4;
+
+float motorValues[NUM_MOTORS] = { 0 };
+double encoderPositions[NUM_MOTORS] = { 0 };
+unsigned long lastSimMillis = 0;
+
+void processDataReceived()
+{
+    for (int i = 0; i < NUM_MOTORS; i++) {
+        motorValues[i] = xswc.getValue_xrp_motor(i);
+    }
+}
+
+void collectDataToSend()
+{
+    for (int i = 0; i < NUM_MOTORS; i++) {
+        xswc.sendValue_xrp_encoder(i, (int32_t)encoderPositions[i]);
+    }
+    xswc.sendValue_xrp_analog(0, 7.4f); // battery voltage
+    xswc.sendValue_xrp_dio(0, false);
+}
+
+#ifndef PIO_UNIT_TESTING // pio test -e native builds this file too, the tests have their own main()
+int main()
+{
+    if (!xswc.begin(processDataReceived, collectDataToSend, 3540)) {
+        Serial.println("failed to start");
+        return 1;
+    }
+    while (true) {
+        xswc.update();
+
+        unsigned long now = millis();
+        double dt = (now - lastSimMillis) / 1000.0;
+        lastSimMillis = now;
+        for (int i = 0; i < NUM_MOTORS; i++) {
+            float value = xswc.isConnectedAndEnabled() ? motorValues[i] : 0.0f;
+            encoderPositions[i] += value * 1000.0 * dt; // 1000 ticks per second at full power
+        }
+
+        delay(1);
+    }
+}
+#endif
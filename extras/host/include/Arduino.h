@@ -0,0 +1,128 @@
+/**
+ * Minimal stand-in for the Arduino core, so the library can be compiled and profiled on Linux.
+ * Only what xrp-style-wpilib-comms and the host tools use is provided.
+ */
+#pragma once
+
+#include <cstdarg>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+class String {
+public:
+    String(const char* str = "")
+        : str(str)
+    {
+    }
+    String(const std::string& str)
+        : str(str)
+    {
+    }
+    const char* c_str() const
+    {
+        return str.c_str();
+    }
+    size_t length() const
+    {
+        return str.length();
+    }
+
+protected:
+    std::string str;
+};
+
+/**
+ * @brief  base class for anything bytes can be written to, like the Arduino Print class
+ */
+class Print {
+public:
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* buffer, size_t size)
+    {
+        size_t n = 0;
+        while (size--) {
+            n += write(*buffer++);
+        }
+        return n;
+    }
+    size_t print(const char* str)
+    {
+        return write((const uint8_t*)str, strlen(str));
+    }
+    size_t print(const String& str)
+    {
+        return print(str.c_str());
+    }
+    size_t print(long num)
+    {
+        return printf("%ld", num);
+    }
+    size_t print(unsigned long num)
+    {
+        return printf("%lu", num);
+    }
+    size_t print(int num)
+    {
+        return printf("%d", num);
+    }
+    size_t print(double num)
+    {
+        return printf("%.2f", num);
+    }
+    template <typename T>
+    size_t println(T value)
+    {
+        size_t n = print(value);
+        return n + print("\r\n");
+    }
+    size_t println()
+    {
+        return print("\r\n");
+    }
+    size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3)))
+    {
+        char buf[256];
+        va_list args;
+        va_start(args, format);
+        int len = vsnprintf(buf, sizeof(buf), format, args);
+        va_end(args);
+        if (len < 0) {
+            return 0;
+        }
+        return write((const uint8_t*)buf, (size_t)len < sizeof(buf) ? len : sizeof(buf) - 1);
+    }
+    virtual ~Print() { }
+};
+
+/**
+ * @brief  Serial writes to stdout
+ */
+class HardwareSerial : public Print {
+public:
+    void begin(unsigned long baud) { }
+    size_t write(uint8_t c) override
+    {
+        return fwrite(&c, 1, 1, stdout);
+    }
+    size_t write(const uint8_t* buffer, size_t size) override
+    {
+        return fwrite(buffer, 1, size, stdout);
+    }
+    void flush()
+    {
+        fflush(stdout);
+    }
+};
+
+extern HardwareSerial Serial;
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "Arduino.h"
+
+/**
+ * @brief  IPv4 address, like the Arduino IPAddress class
+ */
+class IPAddress {
+public:
+    IPAddress()
+        : IPAddress(0, 0, 0, 0)
+    {
+    }
+    IPAddress(uint8_t first, uint8_t second, uint8_t third, uint8_t fourth)
+    {
+        octets[0] = first;
+        octets[1] = second;
+        octets[2] = third;
+        octets[3] = fourth;
+    }
+    bool operator==(const IPAddress& other) const
+    {
+        return memcmp(octets, other.octets, sizeof(octets)) == 0;
+    }
+    bool operator!=(const IPAddress& other) const
+    {
+        return !(*this == other);
+    }
+    uint8_t operator[](int index) const
+    {
+        return octets[index];
+    }
+    String toString() const
+    {
+        char buf[16];
+        snprintf(buf, sizeof(buf), "%u.%u.%u.%u", octets[0], octets[1], octets[2], octets[3]);
+        return String(buf);
+    }
+
+protected:
+    uint8_t octets[4];
+};
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "Udp.h"
+
+#include <deque>
+#include <vector>
+
+/**
+ * @brief  UDP implementation that keeps datagrams in memory, for driving XSWC without a network
+ * Queue datagrams with inject(), then XSWC::update() reads them. Datagrams XSWC sends are collected in sent.
+ */
+class MockUDP : public UDP {
+public:
+    struct Datagram {
+        std::vector<uint8_t> data;
+        IPAddress addr;
+        uint16_t port;
+    };
+
+    /**
+     * @brief  queue a datagram to be received
+     */
+    void inject(const void* data, size_t length, IPAddress from = IPAddress(127, 0, 0, 1), uint16_t fromPort = 3541)
+    {
+        const uint8_t* bytes = (const uint8_t*)data;
+        incoming.push_back({ std::vector<uint8_t>(bytes, bytes + length), from, fromPort });
+    }
+
+    uint8_t begin(uint16_t port) override
+    {
+        return 1;
+    }
+    void stop() override { }
+    int beginPacket(IPAddress ip, uint16_t port) override
+    {
+        outgoing.data.clear();
+        outgoing.addr = ip;
+        outgoing.port = port;
+        return 1;
+    }
+    int endPacket() override
+    {
+        if (keepSent) {
+            sent.push_back(outgoing);
+        }
+        sentCount++;
+        return 1;
+    }
+    size_t write(uint8_t c) override
+    {
+        outgoing.data.push_back(c);
+        return 1;
+    }
+    size_t write(const uint8_t* buffer, size_t size) override
+    {
+        outgoing.data.insert(outgoing.data.end(), buffer, buffer + size);
+        return size;
+    }
+    int parsePacket() override
+    {
+        if (incoming.empty()) {
+            return 0;
+        }
+        current = incoming.front();
+        incoming.pop_front();
+        pos = 0;
+        return current.data.size();
+    }
+    int available() override
+    {
+        return current.data.size() - pos;
+    }
+    int read(unsigned char* buffer, size_t len) override
+    {
+        size_t n = current.data.size() - pos;
+        if (n > len) {
+            n = len;
+        }
+        memcpy(buffer, current.data.data() + pos, n);
+        pos += n;
+        return n;
+    }
+    int read(char* buffer, size_t len) override
+    {
+        return read((unsigned char*)buffer, len);
+    }
+    IPAddress remoteIP() override
+    {
+        return current.addr;
+    }
+    uint16_t remotePort() override
+    {
+        return current.port;
+    }
+
+    std::deque<Datagram> incoming;
+    std::vector<Datagram> sent;
+    bool keepSent = true; // set to false to only count sent datagrams
+    size_t sentCount = 0;
+
+protected:
+    Datagram current;
+    Datagram outgoing;
+    size_t pos = 0;
+};
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "Arduino.h"
+#include "IPAddress.h"
+
+/**
+ * @brief  the subset of the Arduino UDP interface that the library uses
+ */
+class UDP : public Print {
+public:
+    virtual uint8_t begin(uint16_t port) = 0;
+    virtual void stop() = 0;
+    virtual int beginPacket(IPAddress ip, uint16_t port) = 0;
+    virtual int endPacket() = 0;
+    virtual int parsePacket() = 0;
+    virtual int available() = 0;
+    virtual int read(unsigned char* buffer, size_t len) = 0;
+    virtual int read(char* buffer, size_t len) = 0;
+    virtual IPAddress remoteIP() = 0;
+    virtual uint16_t remotePort() = 0;
+    using Print::write;
+};
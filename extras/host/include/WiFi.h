@@ -0,0 +1,50 @@
+#pragma once
+
+#include "Arduino.h"
+#include "IPAddress.h"
+
+typedef enum {
+    WIFI_OFF,
+    WIFI_STA,
+    WIFI_AP,
+    WIFI_AP_STA,
+} wifi_mode_t;
+
+#define WL_CONNECTED 3
+
+/**
+ * @brief  there's no WiFi to set up on a computer, the computer's own network is used
+ */
+class WiFiClass {
+public:
+    bool setHostname(const char* hostname)
+    {
+        return true;
+    }
+    bool mode(wifi_mode_t mode)
+    {
+        return true;
+    }
+    bool disconnect()
+    {
+        return true;
+    }
+    bool softAP(const char* ssid, const char* password)
+    {
+        return true;
+    }
+    IPAddress softAPIP()
+    {
+        return IPAddress(127, 0, 0, 1);
+    }
+    IPAddress localIP()
+    {
+        return IPAddress(127, 0, 0, 1);
+    }
+    String SSID()
+    {
+        return String("host");
+    }
+};
+
+extern WiFiClass WiFi;
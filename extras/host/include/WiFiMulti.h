@@ -0,0 +1,15 @@
+#pragma once
+
+#include "WiFi.h"
+
+class WiFiMulti {
+public:
+    bool addAP(const char* ssid, const char* password)
+    {
+        return true;
+    }
+    uint8_t run()
+    {
+        return WL_CONNECTED;
+    }
+};
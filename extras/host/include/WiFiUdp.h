@@ -0,0 +1,36 @@
+#pragma once
+
+#include "Udp.h"
+
+#include <vector>
+
+/**
+ * @brief  UDP over a non-blocking POSIX socket
+ */
+class WiFiUDP : public UDP {
+public:
+    uint8_t begin(uint16_t port) override;
+    void stop() override;
+    int beginPacket(IPAddress ip, uint16_t port) override;
+    int endPacket() override;
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t* buffer, size_t size) override;
+    int parsePacket() override;
+    int available() override;
+    int read(unsigned char* buffer, size_t len) override;
+    int read(char* buffer, size_t len) override;
+    IPAddress remoteIP() override;
+    uint16_t remotePort() override;
+    ~WiFiUDP();
+
+protected:
+    int fd = -1;
+    std::vector<uint8_t> rxData;
+    size_t rxLength = 0;
+    size_t rxPos = 0;
+    IPAddress rxAddr;
+    uint16_t rxPort = 0;
+    std::vector<uint8_t> txData;
+    IPAddress txAddr;
+    uint16_t txPort = 0;
+};
@@ -0,0 +1,131 @@
+#include "WiFiUdp.h"
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+static const size_t MAX_DATAGRAM_SIZE = 65536;
+
+uint8_t WiFiUDP::begin(uint16_t port)
+{
+    stop();
+    fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0) {
+        return 0;
+    }
+    int reuse = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port);
+    if (bind(fd, (sockaddr*)&addr, sizeof(addr)) < 0) {
+        stop();
+        return 0;
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+    rxData.resize(MAX_DATAGRAM_SIZE);
+    txData.reserve(MAX_DATAGRAM_SIZE);
+    return 1;
+}
+
+void WiFiUDP::stop()
+{
+    if (fd >= 0) {
+        close(fd);
+        fd = -1;
+    }
+}
+
+int WiFiUDP::beginPacket(IPAddress ip, uint16_t port)
+{
+    txData.clear();
+    txAddr = ip;
+    txPort = port;
+    return 1;
+}
+
+int WiFiUDP::endPacket()
+{
+    if (fd < 0) {
+        return 0;
+    }
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(((uint32_t)txAddr[0] << 24) | ((uint32_t)txAddr[1] << 16) | ((uint32_t)txAddr[2] << 8) | txAddr[3]);
+    addr.sin_port = htons(txPort);
+    ssize_t sent = sendto(fd, txData.data(), txData.size(), 0, (sockaddr*)&addr, sizeof(addr));
+    return sent == (ssize_t)txData.size() ? 1 : 0;
+}
+
+size_t WiFiUDP::write(uint8_t c)
+{
+    return write(&c, 1);
+}
+
+size_t WiFiUDP::write(const uint8_t* buffer, size_t size)
+{
+    if (txData.size() + size > MAX_DATAGRAM_SIZE) {
+        size = MAX_DATAGRAM_SIZE - txData.size();
+    }
+    txData.insert(txData.end(), buffer, buffer + size);
+    return size;
+}
+
+int WiFiUDP::parsePacket()
+{
+    rxLength = 0;
+    rxPos = 0;
+    if (fd < 0) {
+        return 0;
+    }
+    sockaddr_in addr = {};
+    socklen_t addrLength = sizeof(addr);
+    ssize_t received = recvfrom(fd, rxData.data(), rxData.size(), 0, (sockaddr*)&addr, &addrLength);
+    if (received <= 0) {
+        return 0;
+    }
+    rxLength = received;
+    uint32_t ip = ntohl(addr.sin_addr.s_addr);
+    rxAddr = IPAddress(ip >> 24, ip >> 16, ip >> 8, ip);
+    rxPort = ntohs(addr.sin_port);
+    return rxLength;
+}
+
+int WiFiUDP::available()
+{
+    return rxLength - rxPos;
+}
+
+int WiFiUDP::read(unsigned char* buffer, size_t len)
+{
+    size_t n = rxLength - rxPos;
+    if (n > len) {
+        n = len;
+    }
+    memcpy(buffer, rxData.data() + rxPos, n);
+    rxPos += n;
+    return n;
+}
+
+int WiFiUDP::read(char* buffer, size_t len)
+{
+    return read((unsigned char*)buffer, len);
+}
+
+IPAddress WiFiUDP::remoteIP()
+{
+    return rxAddr;
+}
+
+uint16_t WiFiUDP::remotePort()
+{
+    return rxPort;
+}
+
+WiFiUDP::~WiFiUDP()
+{
+    stop();
+}
@@ -0,0 +1,331 @@
+/*
+ * Stand-in for wpilib's halsim_xrp that drives an XSWC robot over loopback UDP and measures it.
+ * The robot runs in a second thread of the same program. Each command carries its sequence number as the value of motor 0,
+ * the robot echoes it back in analog 0 along with encoder blocks derived from it, so round trip times and telemetry contents can be checked.
+ * Build and run with PlatformIO: pio run -e native_loadgen && .pio/build/native_loadgen/program [options]
+ *   --rate HZ         commands per second, default 50
+ *   --seconds S       how long to send commands, default 5
+ *   --mix NAME        blocks in each command: min (motor 0), nou3 (4 motors and 2 servos) or max (a full 1000 byte packet), default nou3
+ *   --policy NAME     robot's txPolicy: periodic, adaptive (periodic with adaptiveTelemetryRate) or reply, default reply
+ *   --task            run the robot's communication in its own task (beginTask)
+ *   --loop-us US      the robot sleeps this long between calls to update(), like the rest of a robot's loop() would take, default 100
+ *   --record FILE     record the robot's packets with a StreamRecorder, for extras/replay
+ *   --port PORT       robot's UDP port, default 3540 (the stand-in uses the next port)
+ *   --label TEXT      copied into the output, to compare library versions
+ * Prints one JSON object, for example:
+ * {"label":"","mix":"nou3","policy":"reply","task":0,"loop_us":100,"rate_hz":50,...,"rtt_us_p50":111,"rtt_us_p99":223,"decode_errors":0}
+ */
+
+#include <xrp-style-wpilib-comms.h>
+
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+// ---- robot side, runs in its own thread
+
+static float echo = 0; // motor 0 of the newest command, only used by the robot thread
+static std::atomic<uint32_t> robotPackets(0);
+static std::atomic<bool> robotRunning(true);
+static unsigned int robotLoopMicros = 100;
+
+static const int ENCODERS = 4;
+
+void robotReceive()
+{
+    echo = xswc.getValue_xrp_motor(0);
+    robotPackets++;
+}
+
+void robotSend()
+{
+    xswc.sendValue_xrp_analog(0, echo);
+    for (int id = 0; id < ENCODERS; id++) {
+        xswc.sendValue_xrp_encoder(id, (int32_t)echo * 16 + id, id, id + 1);
+    }
+}
+
+static void robotLoop()
+{
+    while (robotRunning.load()) {
+        xswc.update();
+        delayMicroseconds(robotLoopMicros);
+    }
+}
+
+// lets StreamRecorder write to a file
+class FilePrint : public Print {
+public:
+    FilePrint(FILE* _file)
+        : file(_file)
+    {
+    }
+    size_t write(uint8_t c) override
+    {
+        return fwrite(&c, 1, 1, file);
+    }
+    size_t write(const uint8_t* buffer, size_t size) override
+    {
+        return fwrite(buffer, 1, size, file);
+    }
+
+protected:
+    FILE* file;
+};
+
+// ---- halsim_xrp stand-in
+
+// append a block to a command packet, the field lists are used directly because the codecs only encode sendable types
+template <typename T>
+static bool appendBlock(char* buf, int& length, const T& data)
+{
+    const int blockSize = codec<T>::blockSize;
+    if (length + blockSize > UDP_PACKET_MAX_SIZE_XRP) {
+        return false;
+    }
+    buf[length] = blockSize - 1;
+    buf[length + 1] = TYPE_TO_TAG_VAL(T);
+    tag_type<T>::fields::encode(data, buf, length + 2);
+    length += blockSize;
+    return true;
+}
+
+static int buildCommand(char* buf, uint16_t sequence, const char* mix)
+{
+    uint16ToNetwork(sequence, buf);
+    buf[2] = 1; // enabled
+    int length = 3;
+    appendBlock(buf, length, xrp_motor_t { 0, (float)sequence });
+    if (strcmp(mix, "nou3") == 0) {
+        for (uint8_t id = 1; id < 4; id++) {
+            appendBlock(buf, length, xrp_motor_t { id, 0.5f });
+        }
+        appendBlock(buf, length, xrp_servo_t { 4, 0.25f });
+        appendBlock(buf, length, xrp_servo_t { 5, 0.75f });
+    } else if (strcmp(mix, "max") == 0) {
+        for (int i = 0;; i++) {
+            uint8_t id = 1 + i % (XSWC_MAX_CHANNELS_PER_TAG - 1);
+            bool added;
+            switch (i % 4) {
+            case 0:
+                added = appendBlock(buf, length, xrp_motor_t { id, 0.5f });
+                break;
+            case 1:
+                added = appendBlock(buf, length, xrp_servo_t { id, 0.5f });
+                break;
+            case 2:
+                added = appendBlock(buf, length, xrp_dio_t { id, 1 });
+                break;
+            default:
+                added = appendBlock(buf, length, xrp_analog_t { id, 3.3f });
+                break;
+            }
+            if (!added) {
+                break;
+            }
+        }
+    }
+    return length;
+}
+
+static uint32_t sendMicros[65536]; // when each sequence number was sent
+static LatencyHistogram rtt;
+static uint32_t decodeErrors = 0;
+static uint32_t telemetryReceived = 0;
+static int lastEcho = -1;
+
+// check that a telemetry packet is exactly what robotSend() produces, and record the round trip time of the echoed command
+static void checkTelemetry(char* buf, int length)
+{
+    unsigned long now = micros();
+    telemetryReceived++;
+    if (length < 3) {
+        decodeErrors++;
+        return;
+    }
+    int echoed = -1;
+    int encoders = 0;
+    int32_t expected[ENCODERS][3];
+    int32_t got[ENCODERS][3];
+    for (int index = 3; index < length;) {
+        int size = (uint8_t)buf[index] + 1;
+        uint8_t tag = (uint8_t)buf[index + 1];
+        if (index + size > length) {
+            decodeErrors++;
+            return;
+        }
+        if (tag == XRP_TAG_ANALOG && size == codec<xrp_analog_t>::blockSize) {
+            xrp_analog_t analog;
+            tag_type<xrp_analog_t>::fields::decode(analog, buf, index + 2);
+            if (analog.id != 0 || analog.value < 0 || analog.value > 65535 || analog.value != floorf(analog.value)) {
+                decodeErrors++;
+                return;
+            }
+            echoed = (int)analog.value;
+        } else if (tag == XRP_TAG_ENCODER && size == codec<xrp_encoder_t>::blockSize) {
+            xrp_encoder_t encoder;
+            tag_type<xrp_encoder_t>::fields::decode(encoder, buf, index + 2);
+            if (encoder.id >= ENCODERS) {
+                decodeErrors++;
+                return;
+            }
+            got[encoder.id][0] = encoder.count;
+            got[encoder.id][1] = encoder.period;
+            got[encoder.id][2] = encoder.divisor;
+            encoders++;
+        } else {
+            decodeErrors++;
+            return;
+        }
+        index += size;
+    }
+    if (echoed < 0 || encoders != ENCODERS) {
+        decodeErrors++;
+        return;
+    }
+    for (int id = 0; id < ENCODERS; id++) {
+        expected[id][0] = echoed * 16 + id;
+        expected[id][1] = id;
+        expected[id][2] = id + 1;
+        if (memcmp(expected[id], got[id], sizeof(expected[id])) != 0) {
+            decodeErrors++;
+            return;
+        }
+    }
+    if (echoed != lastEcho) { // periodic telemetry repeats the same echo until the next command arrives
+        rtt.record(now - sendMicros[echoed]);
+        lastEcho = echoed;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    double rate = 50;
+    double seconds = 5;
+    const char* mix = "nou3";
+    const char* policy = "reply";
+    bool useTask = false;
+    uint16_t port = 3540;
+    const char* label = "";
+    const char* recordPath = nullptr;
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--rate") == 0 && hasValue) {
+            rate = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--seconds") == 0 && hasValue) {
+            seconds = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--mix") == 0 && hasValue) {
+            mix = argv[++i];
+        } else if (strcmp(argv[i], "--policy") == 0 && hasValue) {
+            policy = argv[++i];
+        } else if (strcmp(argv[i], "--task") == 0) {
+            useTask = true;
+        } else if (strcmp(argv[i], "--loop-us") == 0 && hasValue) {
+            robotLoopMicros = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--record") == 0 && hasValue) {
+            recordPath = argv[++i];
+        } else if (strcmp(argv[i], "--port") == 0 && hasValue) {
+            port = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--label") == 0 && hasValue) {
+            label = argv[++i];
+        } else {
+            fprintf(stderr, "unknown option %s, see the comment at the top of loadgen.cpp\n", argv[i]);
+            return 1;
+        }
+    }
+    if (rate <= 0 || (strcmp(mix, "min") != 0 && strcmp(mix, "nou3") != 0 && strcmp(mix, "max") != 0)) {
+        fprintf(stderr, "invalid --rate or --mix\n");
+        return 1;
+    }
+
+    FILE* recordFile = nullptr;
+    FilePrint* recordPrint = nullptr;
+    StreamRecorder* recorder = nullptr;
+    if (recordPath != nullptr) {
+        recordFile = fopen(recordPath, "wb");
+        if (recordFile == nullptr) {
+            fprintf(stderr, "can't open %s\n", recordPath);
+            return 1;
+        }
+        recordPrint = new FilePrint(recordFile);
+        recorder = new StreamRecorder(*recordPrint);
+        xswc.setRecorder(recorder);
+    }
+
+    xswc.txPolicy = (strcmp(policy, "reply") == 0) ? XSWC::TX_REPLY_ON_RECEIVE : XSWC::TX_PERIODIC;
+    xswc.adaptiveTelemetryRate = (strcmp(policy, "adaptive") == 0);
+    if (!xswc.begin(robotReceive, robotSend, port)) {
+        fprintf(stderr, "robot failed to start\n");
+        return 1;
+    }
+    if (useTask && !xswc.beginTask(-1)) {
+        fprintf(stderr, "robot task failed to start\n");
+        return 1;
+    }
+    std::thread robot(robotLoop);
+
+    WiFiUDP sim;
+    sim.begin(port + 1);
+    IPAddress robotAddress(127, 0, 0, 1);
+    char command[UDP_PACKET_MAX_SIZE_XRP];
+    char telemetry[UDP_PACKET_MAX_SIZE_XRP * 2];
+    uint32_t commandsSent = 0;
+    uint16_t sequence = 0;
+    double periodMicros = 1e6 / rate;
+    unsigned long start = micros();
+    double nextSend = 0; // micros after start
+    unsigned long sendingMicros = (unsigned long)(seconds * 1e6);
+    unsigned long drainMicros = 200000; // keep reading telemetry for a while after the last command
+
+    while (true) {
+        unsigned long elapsed = micros() - start;
+        if (elapsed >= sendingMicros + drainMicros) {
+            break;
+        }
+        if (elapsed < sendingMicros && elapsed >= nextSend) {
+            int length = buildCommand(command, sequence, mix);
+            sendMicros[sequence] = micros();
+            sim.beginPacket(robotAddress, port);
+            sim.write((uint8_t*)command, length);
+            sim.endPacket();
+            sequence++;
+            commandsSent++;
+            nextSend += periodMicros;
+            if (nextSend + 100 * periodMicros < elapsed) {
+                nextSend = elapsed; // don't send a burst to catch up after a stall
+            }
+        }
+        bool idle = true;
+        while (sim.parsePacket()) {
+            int length = sim.read(telemetry, sizeof(telemetry));
+            checkTelemetry(telemetry, length);
+            idle = false;
+        }
+        if (idle && nextSend - elapsed > 20) {
+            delayMicroseconds(10); // let the robot thread run, there may be only one core
+        }
+    }
+
+    robotRunning = false;
+    robot.join();
+    xswc.endTask();
+    if (recorder != nullptr) {
+        xswc.setRecorder(nullptr);
+        delete recorder;
+        delete recordPrint;
+        fclose(recordFile);
+    }
+
+    XSWC::Stats stats = xswc.getStats();
+    printf("{\"label\":\"%s\",\"mix\":\"%s\",\"policy\":\"%s\",\"task\":%d,\"loop_us\":%u,\"rate_hz\":%.0f,\"seconds\":%.1f,"
+           "\"commands_sent\":%u,\"commands_per_s\":%.1f,\"robot_packets_per_s\":%.1f,\"telemetry_per_s\":%.1f,"
+           "\"rtt_samples\":%u,\"rtt_us_p50\":%u,\"rtt_us_p90\":%u,\"rtt_us_p99\":%u,\"rtt_us_max\":%u,"
+           "\"decode_errors\":%u,\"robot_lost\":%u,\"robot_coalesced\":%u}\n",
+        label, mix, policy, useTask ? 1 : 0, robotLoopMicros, rate, seconds,
+        commandsSent, commandsSent / seconds, robotPackets.load() / seconds, telemetryReceived / seconds,
+        rtt.getCount(), rtt.percentile(0.5f), rtt.percentile(0.9f), rtt.percentile(0.99f), rtt.getMax(),
+        decodeErrors, stats.packetsLost, stats.packetsCoalesced);
+    return decodeErrors == 0 ? 0 : 2;
+}
@@ -0,0 +1,211 @@
+/*
+ * Plays a recording made with XSWC::setRecorder() back through the library on a computer.
+ * Every received datagram is handed to xswc.update() through MockUDP, with the clock set to the time it was recorded,
+ * so parsing, sequence tracking, timeouts and the callbacks run exactly as they did on the robot. Datagrams that came from
+ * the connected remote are sent from 127.0.0.1, ones from other computers (that the robot ignored) from 127.0.0.2.
+ * Build and run with PlatformIO: pio run -e native_replay && .pio/build/native_replay/program recording.bin [options]
+ *   --realtime        wait between packets like they were recorded, instead of replaying as fast as possible
+ *   --repeat N        replay the recording N times, to use it as a benchmark, default 1
+ *   --print           print the enable bit and motors 0 to 3 each time receiveCallback runs
+ *   --label TEXT      copied into the output, to compare library versions
+ * The recording doesn't say how the robot sent telemetry, so set it like the robot's sketch did to compare the sends:
+ *   --policy P        periodic (TX_PERIODIC, the default) or reply (TX_REPLY_ON_RECEIVE)
+ *   --interval MS     MIN_UPDATE_TIME_MS, time between periodic sends, default 50
+ *   --adaptive-rate   set adaptiveTelemetryRate, periodic sends follow the command rate
+ *   --heartbeat MS    HEARTBEAT_MS, reply sends this often when no commands arrive, default 50
+ *   --min-reply-spacing MS   MIN_REPLY_SPACING_MS, default 0
+ *   --loop MS         also call update() every MS of recorded time between packets, like the robot's loop does,
+ *                     so periodic and heartbeat sends happen without --realtime, default 0 (only when a packet arrives)
+ * Prints one JSON object, for example:
+ * {"label":"","policy":"periodic","records":5123,"received":4870,"from_other_remotes":0,"sent_recorded":253,"sent_replayed":250,"ns_per_packet":310.5,...}
+ */
+
+#include <xrp-style-wpilib-comms.h>
+
+#include <MockUdp.h>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+struct Record {
+    PacketRecorder::Direction direction;
+    uint32_t micros;
+    std::vector<uint8_t> data;
+};
+
+// read records, skipping bytes that aren't part of one (a recording captured from Serial can have other output mixed in)
+static std::vector<Record> readRecording(const char* path, uint32_t& skippedBytes)
+{
+    std::vector<Record> records;
+    FILE* file = fopen(path, "rb");
+    if (file == nullptr) {
+        return records;
+    }
+    std::vector<uint8_t> bytes;
+    uint8_t chunk[4096];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+        bytes.insert(bytes.end(), chunk, chunk + n);
+    }
+    fclose(file);
+
+    skippedBytes = 0;
+    size_t pos = 0;
+    while (pos + PacketRecorder::HEADER_SIZE <= bytes.size()) {
+        const uint8_t* header = bytes.data() + pos;
+        size_t length = ((size_t)header[6] << 8) | header[7];
+        if (header[0] != PacketRecorder::SYNC || header[1] > PacketRecorder::RECEIVED_FROM_OTHER_REMOTE || length < 1 || pos + PacketRecorder::HEADER_SIZE + length > bytes.size()) {
+            pos++;
+            skippedBytes++;
+            continue;
+        }
+        Record record;
+        record.direction = (PacketRecorder::Direction)header[1];
+        record.micros = networkToUInt32((const char*)header, 2);
+        record.data.assign(header + PacketRecorder::HEADER_SIZE, header + PacketRecorder::HEADER_SIZE + length);
+        records.push_back(std::move(record));
+        pos += PacketRecorder::HEADER_SIZE + length;
+    }
+    skippedBytes += bytes.size() - pos;
+    return records;
+}
+
+// the robot's clock follows the recording
+static uint64_t replayMicros = 0;
+static unsigned long replayClockMillis()
+{
+    return replayMicros / 1000;
+}
+static unsigned long replayClockMicros()
+{
+    return replayMicros;
+}
+
+static bool printValues = false;
+static uint32_t receiveCallbacks = 0;
+static uint32_t sendCallbacks = 0;
+
+void replayReceive()
+{
+    receiveCallbacks++;
+    float motors[4];
+    xswc.getValues_xrp_motor(motors, 4);
+    if (printValues) {
+        printf("%.3f ms enabled %d motors %.3f %.3f %.3f %.3f\n", replayMicros / 1000.0, xswc.isEnabled(), motors[0], motors[1], motors[2], motors[3]);
+    }
+}
+
+void replaySend()
+{
+    sendCallbacks++;
+    xswc.sendValue_xrp_analog(0, receiveCallbacks);
+}
+
+int main(int argc, char** argv)
+{
+    const char* path = nullptr;
+    bool realtime = false;
+    int repeat = 1;
+    const char* label = "";
+    const char* policy = "periodic";
+    unsigned long loopMicros = 0;
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--realtime") == 0) {
+            realtime = true;
+        } else if (strcmp(argv[i], "--repeat") == 0 && hasValue) {
+            repeat = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--print") == 0) {
+            printValues = true;
+        } else if (strcmp(argv[i], "--label") == 0 && hasValue) {
+            label = argv[++i];
+        } else if (strcmp(argv[i], "--policy") == 0 && hasValue && (strcmp(argv[i + 1], "periodic") == 0 || strcmp(argv[i + 1], "reply") == 0)) {
+            policy = argv[++i];
+            xswc.txPolicy = strcmp(policy, "reply") == 0 ? XSWC::TX_REPLY_ON_RECEIVE : XSWC::TX_PERIODIC;
+        } else if (strcmp(argv[i], "--interval") == 0 && hasValue) {
+            xswc.MIN_UPDATE_TIME_MS = strtoul(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--adaptive-rate") == 0) {
+            xswc.adaptiveTelemetryRate = true;
+        } else if (strcmp(argv[i], "--heartbeat") == 0 && hasValue) {
+            xswc.HEARTBEAT_MS = strtoul(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--min-reply-spacing") == 0 && hasValue) {
+            xswc.MIN_REPLY_SPACING_MS = strtoul(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--loop") == 0 && hasValue) {
+            loopMicros = strtoul(argv[++i], nullptr, 10) * 1000;
+        } else if (path == nullptr && argv[i][0] != '-') {
+            path = argv[i];
+        } else {
+            fprintf(stderr, "unknown option %s, see the comment at the top of replay.cpp\n", argv[i]);
+            return 1;
+        }
+    }
+    if (path == nullptr || repeat < 1) {
+        fprintf(stderr, "usage: %s recording.bin [--realtime] [--repeat N] [--print] [--label TEXT] [--policy periodic|reply] [--interval MS] [--adaptive-rate] [--heartbeat MS] [--min-reply-spacing MS] [--loop MS]\n", argv[0]);
+        return 1;
+    }
+
+    uint32_t skippedBytes = 0;
+    std::vector<Record> records = readRecording(path, skippedBytes);
+    if (records.empty()) {
+        fprintf(stderr, "no records in %s\n", path);
+        return 1;
+    }
+
+    MockUDP mock;
+    mock.keepSent = false;
+    xswc.setTransport(mock);
+    xswc.setClock(replayClockMillis, replayClockMicros);
+    xswc.begin(replayReceive, replaySend);
+
+    uint32_t received = 0;
+    uint32_t fromOtherRemotes = 0;
+    uint32_t sentRecorded = 0;
+    auto wallStart = std::chrono::steady_clock::now();
+    for (int pass = 0; pass < repeat; pass++) {
+        uint32_t previousMicros = records[0].micros;
+        for (const Record& record : records) {
+            uint64_t recordMicros = replayMicros + (uint32_t)(record.micros - previousMicros); // the recorded clock is 32 bits, so it can wrap around
+            previousMicros = record.micros;
+            if (loopMicros > 0 && !realtime) {
+                for (uint64_t next = replayMicros + loopMicros; next < recordMicros; next += loopMicros) {
+                    replayMicros = next;
+                    xswc.update();
+                }
+            }
+            replayMicros = recordMicros;
+            if (record.direction == PacketRecorder::SENT) {
+                sentRecorded++;
+                continue;
+            }
+            if (realtime) {
+                auto due = wallStart + std::chrono::microseconds(replayMicros);
+                while (std::chrono::steady_clock::now() < due) {
+                    xswc.update(); // nothing to receive, but periodic telemetry is sent like on the robot
+                    std::this_thread::sleep_for(std::chrono::microseconds(100));
+                }
+            }
+            if (record.direction == PacketRecorder::RECEIVED_FROM_OTHER_REMOTE) {
+                mock.inject(record.data.data(), record.data.size(), IPAddress(127, 0, 0, 2));
+                fromOtherRemotes++;
+            } else {
+                mock.inject(record.data.data(), record.data.size());
+                received++;
+            }
+            xswc.update();
+        }
+        replayMicros += 1000000; // longer than the timeout, so the next pass starts like a new connection
+        xswc.update();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+
+    XSWC::Stats stats = xswc.getStats();
+    printf("{\"label\":\"%s\",\"policy\":\"%s\",\"records\":%zu,\"skipped_bytes\":%u,\"passes\":%d,\"received\":%u,\"from_other_remotes\":%u,\"sent_recorded\":%u,\"sent_replayed\":%zu,"
+           "\"receive_callbacks\":%u,\"send_callbacks\":%u,\"seconds\":%.3f,\"ns_per_packet\":%.1f,"
+           "\"lost\":%u,\"duplicated\":%u,\"reordered\":%u,\"ignored_other_remotes\":%u,\"link_timeouts\":%u}\n",
+        label, policy, records.size(), skippedBytes, repeat, received, fromOtherRemotes, sentRecorded, mock.sentCount,
+        receiveCallbacks, sendCallbacks, seconds, received ? seconds * 1e9 / received : 0.0,
+        stats.packetsLost, stats.packetsDuplicated, stats.packetsReordered, stats.packetsFromOtherRemotes, stats.linkTimeouts);
+    return 0;
+}
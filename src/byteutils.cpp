@@ -1,89 +1,52 @@
+
 #include <cstring>
 
 // from https://github.com/wpilibsuite/xrp-wpilib-firmware/blob/main/src/byteutils.cpp
+// the scalar functions are now inline in byteutils.h, this file has the functions for arrays of values
 
 #include "byteutils.h"
 
-// NOTE: The RP2040 is Little Endian, and Network Byte Order is Big Endian
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#endif
 
-float networkToFloat(char* buf, int offset) {
-  float f;
-  unsigned char b[] = {buf[offset+3], buf[offset+2], buf[offset+1], buf[offset+0]};
-  memcpy(&f, &b, sizeof(f));
-  return f;
+// copy count 4-byte values from src to dst, converting between host and Network Byte Order
+static void copySwap32(void* dst, const void* src, int count) {
+  char* d = (char*)dst;
+  const char* s = (const char*)src;
+  if constexpr (BYTEUTILS_HOST_IS_BIG_ENDIAN) {
+    memmove(d, s, count * 4);
+    return;
+  }
+  int i = 0;
+#if defined(__SSSE3__)
+  // swap four values at a time
+  const __m128i reverseEachWord = _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+  for (; i + 4 <= count; i += 4) {
+    __m128i v = _mm_loadu_si128((const __m128i*)(s + i * 4));
+    _mm_storeu_si128((__m128i*)(d + i * 4), _mm_shuffle_epi8(v, reverseEachWord));
+  }
+#endif
+  for (; i < count; i++) {
+    uint32_t u;
+    memcpy(&u, s + i * 4, sizeof(u));
+    u = byteutilsSwap32(u);
+    memcpy(d + i * 4, &u, sizeof(u));
+  }
 }
 
-int16_t networkToInt16(char* buf, int offset) {
-  int16_t i;
-  unsigned char b[] = {buf[offset+1], buf[offset+0]};
-  memcpy(&i, &b, sizeof(i));
-  return i;
+void floatsToNetwork(const float* nums, int count, char* buf, int offset) {
+  copySwap32(buf + offset, nums, count);
 }
 
-uint16_t networkToUInt16(char* buf, int offset) {
-  uint16_t u;
-  unsigned char b[] = {buf[offset+1], buf[offset+0]};
-  memcpy(&u, &b, sizeof(u));
-  return u;
+void networkToFloats(float* nums, int count, const char* buf, int offset) {
+  copySwap32(nums, buf + offset, count);
 }
 
-int32_t networkToInt32(char* buf, int offset) {
-  int32_t i;
-  unsigned char b[] = {buf[offset+3], buf[offset+2], buf[offset+1], buf[offset+0]};
-  memcpy(&i, &b, sizeof(i));
-  return i;
+void int32sToNetwork(const int32_t* nums, int count, char* buf, int offset) {
+  copySwap32(buf + offset, nums, count);
 }
 
-uint32_t networkToUInt32(char* buf, int offset) {
-  uint32_t u;
-  unsigned char b[] = {buf[offset+3], buf[offset+2], buf[offset+1], buf[offset+0]};
-  memcpy(&u, &b, sizeof(u));
-  return u;
+void networkToInt32s(int32_t* nums, int count, const char* buf, int offset) {
+  copySwap32(nums, buf + offset, count);
 }
-
-void floatToNetwork(float num, char* buf, int offset) {
-  unsigned char b[4];
-  memcpy(&b, &num, sizeof(num));
-
-  buf[offset+0] = b[3];
-  buf[offset+1] = b[2];
-  buf[offset+2] = b[1];
-  buf[offset+3] = b[0];
-}
-
-void int16ToNetwork(int16_t num, char* buf, int offset) {
-  unsigned char b[2];
-  memcpy(&b, &num, sizeof(num));
-
-  buf[offset+0] = b[1];
-  buf[offset+1] = b[0];
-}
-
-void uint16ToNetwork(uint16_t num, char* buf, int offset) {
-  unsigned char b[2];
-  memcpy(&b, &num, sizeof(num));
-
-  buf[offset+0] = b[1];
-  buf[offset+1] = b[0];
-}
-
-void int32ToNetwork(int32_t num, char* buf, int offset) {
-  unsigned char b[4];
-  memcpy(&b, &num, sizeof(num));
-
-  buf[offset+0] = b[3];
-  buf[offset+1] = b[2];
-  buf[offset+2] = b[1];
-  buf[offset+3] = b[0];
-}
-
-void uint32ToNetwork(uint32_t num, char* buf, int offset) {
-  unsigned char b[4];
-  memcpy(&b, &num, sizeof(num));
-
-  buf[offset+0] = b[3];
-  buf[offset+1] = b[2];
-  buf[offset+2] = b[1];
-  buf[offset+3] = b[0];
-}
-
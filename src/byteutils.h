@@ -2,57 +2,139 @@
 #define BYTEUTILS_H
 
 // from https://github.com/wpilibsuite/xrp-wpilib-firmware/blob/main/include/byteutils.h
+// the scalar functions are inline so encoding a block compiles down to loads, byte swaps and stores
 
 #include <stdint.h>
+#include <string.h>
+
+// NOTE: Network Byte Order is Big Endian, most microcontrollers (including the RP2040 and ESP32) are Little Endian
+#if defined(__BYTE_ORDER__) && defined(__ORDER_BIG_ENDIAN__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+constexpr bool BYTEUTILS_HOST_IS_BIG_ENDIAN = true;
+#else
+constexpr bool BYTEUTILS_HOST_IS_BIG_ENDIAN = false;
+#endif
+
 /**
- * Decode a float from a 4-byte buffer in Network Byte order
+ * Convert a 16 bit value between host and Network Byte Order (the conversion is the same in both directions)
  */
-float networkToFloat(char* buf, int offset = 0);
+inline uint16_t byteutilsSwap16(uint16_t value) {
+  if constexpr (BYTEUTILS_HOST_IS_BIG_ENDIAN) {
+    return value;
+  } else {
+    return __builtin_bswap16(value);
+  }
+}
 
 /**
- * Decode an int16 from a 2-byte buffer in Network Byte order
+ * Convert a 32 bit value between host and Network Byte Order (the conversion is the same in both directions)
  */
-int16_t networkToInt16(char* buf, int offset = 0);
+inline uint32_t byteutilsSwap32(uint32_t value) {
+  if constexpr (BYTEUTILS_HOST_IS_BIG_ENDIAN) {
+    return value;
+  } else {
+    return __builtin_bswap32(value);
+  }
+}
 
 /**
  * Decode an uint16 from a 2-byte buffer in Network Byte order
  */
-uint16_t networkToUInt16(char* buf, int offset = 0);
+inline uint16_t networkToUInt16(const char* buf, int offset = 0) {
+  uint16_t u;
+  memcpy(&u, buf + offset, sizeof(u));
+  return byteutilsSwap16(u);
+}
 
 /**
- * Decode an int32 from a 4-byte buffer in Network Byte order
+ * Decode an int16 from a 2-byte buffer in Network Byte order
  */
-int32_t networkToInt32(char* buf, int offset = 0);
+inline int16_t networkToInt16(const char* buf, int offset = 0) {
+  return (int16_t)networkToUInt16(buf, offset);
+}
 
 /**
  * Decode an uint32 from a 4-byte buffer in Network Byte order
  */
-uint32_t networkToUInt32(char* buf, int offset = 0);
+inline uint32_t networkToUInt32(const char* buf, int offset = 0) {
+  uint32_t u;
+  memcpy(&u, buf + offset, sizeof(u));
+  return byteutilsSwap32(u);
+}
 
 /**
- * Encode a float to a buffer in Network Byte Order
+ * Decode an int32 from a 4-byte buffer in Network Byte order
+ */
+inline int32_t networkToInt32(const char* buf, int offset = 0) {
+  return (int32_t)networkToUInt32(buf, offset);
+}
+
+/**
+ * Decode a float from a 4-byte buffer in Network Byte order
+ */
+inline float networkToFloat(const char* buf, int offset = 0) {
+  uint32_t u = networkToUInt32(buf, offset);
+  float f;
+  memcpy(&f, &u, sizeof(f));
+  return f;
+}
+
+/**
+ * Encode a UInt16 to a buffer in Network Byte Order
 */
-void floatToNetwork(float num, char* buf, int offset = 0);
+inline void uint16ToNetwork(uint16_t num, char* buf, int offset = 0) {
+  uint16_t u = byteutilsSwap16(num);
+  memcpy(buf + offset, &u, sizeof(u));
+}
 
 /**
  * Encode an Int16 to a buffer in Network Byte Order
 */
-void int16ToNetwork(int16_t num, char* buf, int offset = 0);
+inline void int16ToNetwork(int16_t num, char* buf, int offset = 0) {
+  uint16ToNetwork((uint16_t)num, buf, offset);
+}
 
 /**
- * Encode a UInt16 to a buffer in Network Byte Order
+ * Encode a UInt32 to a buffer in Network Byte Order
 */
-void uint16ToNetwork(uint16_t num, char* buf, int offset = 0);
+inline void uint32ToNetwork(uint32_t num, char* buf, int offset = 0) {
+  uint32_t u = byteutilsSwap32(num);
+  memcpy(buf + offset, &u, sizeof(u));
+}
 
 /**
  * Encode an Int32 to a buffer in Network Byte Order
 */
-void int32ToNetwork(int32_t num, char* buf, int offset = 0);
+inline void int32ToNetwork(int32_t num, char* buf, int offset = 0) {
+  uint32ToNetwork((uint32_t)num, buf, offset);
+}
 
 /**
- * Encode a UInt32 to a buffer in Network Byte Order
+ * Encode a float to a buffer in Network Byte Order
 */
-void uint32ToNetwork(uint32_t num, char* buf, int offset = 0);
+inline void floatToNetwork(float num, char* buf, int offset = 0) {
+  uint32_t u;
+  memcpy(&u, &num, sizeof(u));
+  uint32ToNetwork(u, buf, offset);
+}
 
-#endif // BYTEUTILS_H
+/**
+ * Encode count floats to a buffer in Network Byte Order, one after another
+*/
+void floatsToNetwork(const float* nums, int count, char* buf, int offset = 0);
+
+/**
+ * Decode count floats from a buffer in Network Byte Order
+ */
+void networkToFloats(float* nums, int count, const char* buf, int offset = 0);
+
+/**
+ * Encode count Int32s to a buffer in Network Byte Order, one after another
+*/
+void int32sToNetwork(const int32_t* nums, int count, char* buf, int offset = 0);
 
+/**
+ * Decode count Int32s from a buffer in Network Byte Order
+ */
+void networkToInt32s(int32_t* nums, int count, const char* buf, int offset = 0);
+
+#endif // BYTEUTILS_H
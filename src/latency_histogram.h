@@ -0,0 +1,93 @@
+#pragma once
+#include <cstdint>
+
+/**
+ * @brief  Fixed size histogram of durations in microseconds.
+ * Values below 8 have their own buckets, larger values are grouped into 4 buckets per power of two,
+ * so percentiles are accurate to within 25%. Recording a value never allocates memory.
+ */
+class LatencyHistogram {
+public:
+    static constexpr int EXACT_BUCKETS = 8;
+    static constexpr int SUB_BUCKETS = 4; // buckets per power of two above EXACT_BUCKETS
+    static constexpr int NUM_BUCKETS = EXACT_BUCKETS + SUB_BUCKETS * 20; // the last bucket holds everything above about 4 seconds
+
+    /**
+     * @brief  add a value to the histogram
+     */
+    void record(uint32_t micros)
+    {
+        if (count == 0 || micros < minMicros) {
+            minMicros = micros;
+        }
+        if (count == 0 || micros > maxMicros) {
+            maxMicros = micros;
+        }
+        count++;
+        buckets[bucketOf(micros)]++;
+    }
+
+    /**
+     * @brief  forget all recorded values
+     */
+    void reset()
+    {
+        *this = LatencyHistogram();
+    }
+
+    /**
+     * @brief  estimate a percentile of the recorded values
+     * @param  fraction: 0.5 for the median, 0.99 for the 99th percentile
+     * @retval (uint32_t) the upper bound of the bucket containing the percentile (never more than the max), or 0 if nothing was recorded
+     */
+    uint32_t percentile(float fraction) const
+    {
+        if (count == 0) {
+            return 0;
+        }
+        uint32_t target = (uint32_t)(fraction * count + 0.5f);
+        if (target < 1) {
+            target = 1;
+        }
+        uint32_t seen = 0;
+        for (int i = 0; i < NUM_BUCKETS; i++) {
+            seen += buckets[i];
+            if (seen >= target) {
+                uint32_t upper = bucketUpperBound(i);
+                return upper < maxMicros ? upper : maxMicros;
+            }
+        }
+        return maxMicros;
+    }
+
+    uint32_t getCount() const { return count; }
+    uint32_t getMin() const { return minMicros; }
+    uint32_t getMax() const { return maxMicros; }
+
+protected:
+    static int bucketOf(uint32_t micros)
+    {
+        if (micros < EXACT_BUCKETS) {
+            return micros;
+        }
+        int exponent = 31 - __builtin_clz(micros); // at least 3
+        int sub = (micros >> (exponent - 2)) & (SUB_BUCKETS - 1);
+        int bucket = EXACT_BUCKETS + (exponent - 3) * SUB_BUCKETS + sub;
+        return bucket < NUM_BUCKETS ? bucket : NUM_BUCKETS - 1;
+    }
+
+    static uint32_t bucketUpperBound(int bucket)
+    {
+        if (bucket < EXACT_BUCKETS) {
+            return bucket;
+        }
+        int exponent = (bucket - EXACT_BUCKETS) / SUB_BUCKETS + 3;
+        int sub = (bucket - EXACT_BUCKETS) % SUB_BUCKETS;
+        return ((uint32_t)(SUB_BUCKETS + sub + 1) << (exponent - 2)) - 1;
+    }
+
+    uint32_t buckets[NUM_BUCKETS] = {};
+    uint32_t count = 0;
+    uint32_t minMicros = 0;
+    uint32_t maxMicros = 0;
+};
@@ -0,0 +1,109 @@
+#pragma once
+
+// add includes when you add new message types
+#include "message_types/xrp_accel.h"
+#include "message_types/xrp_analog.h"
+#include "message_types/xrp_dio.h"
+#include "message_types/xrp_encoder.h"
+#include "message_types/xrp_gyro.h"
+#include "message_types/xrp_motor.h"
+#include "message_types/xrp_servo.h"
+
+#include "message_type.h"
+
+#include <type_traits>
+
+template <typename... Ts>
+struct type_list { };
+
+/**
+ * @brief  every data struct that has a tag_type specialization (add types here when you add new message types)
+ */
+using xrp_message_types = type_list<xrp_motor_t, xrp_servo_t, xrp_dio_t, xrp_analog_t, xrp_gyro_t, xrp_accel_t, xrp_encoder_t>;
+
+template <typename T, typename List>
+struct type_list_prepend;
+
+template <typename T, typename... Ts>
+struct type_list_prepend<T, type_list<Ts...>> {
+    using type = type_list<T, Ts...>;
+};
+
+/**
+ * @brief  the types in a type_list that can be received from wpilib
+ */
+template <typename List>
+struct receivable_types;
+
+template <>
+struct receivable_types<type_list<>> {
+    using type = type_list<>;
+};
+
+template <typename T, typename... Ts>
+struct receivable_types<type_list<T, Ts...>> {
+    using rest = typename receivable_types<type_list<Ts...>>::type;
+    using type = typename std::conditional<tag_type<T>::receivable, typename type_list_prepend<T, rest>::type, rest>::type;
+};
+
+using xrp_receivable_types = receivable_types<xrp_message_types>::type;
+
+/**
+ * @brief  the types in a type_list that can be sent to wpilib
+ */
+template <typename List>
+struct sendable_types;
+
+template <>
+struct sendable_types<type_list<>> {
+    using type = type_list<>;
+};
+
+template <typename T, typename... Ts>
+struct sendable_types<type_list<T, Ts...>> {
+    using rest = typename sendable_types<type_list<Ts...>>::type;
+    using type = typename std::conditional<tag_type<T>::sendable, typename type_list_prepend<T, rest>::type, rest>::type;
+};
+
+using xrp_sendable_types = sendable_types<xrp_message_types>::type;
+
+/**
+ * @brief  encodes and decodes a whole block (size byte, tag, fields) using the fields listed in tag_type<T>
+ * Only the codecs for types that are actually sent or received get compiled into the program.
+ */
+template <typename T>
+struct codec {
+    using fields = typename tag_type<T>::fields;
+    static constexpr uint8_t tag = tag_type<T>::value;
+    static constexpr int blockSize = 2 + fields::size; // size byte, tag byte, fields
+
+    /**
+     * @brief  write a block into buffer starting at pos
+     * @retval (int) number of bytes written (including the size byte), or 0 if there isn't enough space
+     */
+    static int encode(const T& data, char* buffer, int pos, int end)
+    {
+        static_assert(tag_type<T>::sendable, "this message type can't be sent");
+        if (end - pos < blockSize) {
+            return 0;
+        }
+        buffer[pos] = blockSize - 1; // size excluding size byte itself
+        buffer[pos + 1] = tag;
+        fields::encode(data, buffer, pos + 2);
+        return blockSize;
+    }
+
+    /**
+     * @brief  read a block from buffer, buffer[pos] is the tag, which should have already been checked
+     * @retval (int) number of bytes read (including the tag), or 0 if the buffer is too short
+     */
+    static int decode(T& data, char* buffer, int pos, int end)
+    {
+        static_assert(tag_type<T>::receivable, "this message type can't be received");
+        if (end - pos < blockSize - 1) {
+            return 0;
+        }
+        fields::decode(data, buffer, pos + 1);
+        return blockSize - 1;
+    }
+};
@@ -1,5 +1,8 @@
 #pragma once
+#include "byteutils.h"
+#include <cstddef>
 #include <cstdint>
+#include <type_traits>
 class MessageType {
 public:
     virtual int getTag() = 0;
@@ -21,4 +24,167 @@ struct tag_type {
 
 #define TYPE_TO_TAG_VAL(type) (tag_type<type>::value)
 
+#define XRP_TAG_FIRST 0x12 // lowest tag used by the message types in message_types/
+#define XRP_TAG_COUNT 7 // number of consecutive tags starting at XRP_TAG_FIRST
+
 #define HAS_ID(type) (tag_type<type>::hasId)
+
+/**
+ * @brief  how a value of one type is written in network byte order
+ */
+template <typename U>
+struct field_codec;
+
+template <>
+struct field_codec<uint8_t> {
+    static constexpr int size = 1;
+    static void encode(const uint8_t& value, char* buf, int pos) { buf[pos] = value; }
+    static void decode(uint8_t& value, char* buf, int pos) { value = (uint8_t)buf[pos]; }
+};
+
+template <>
+struct field_codec<int32_t> {
+    static constexpr int size = 4;
+    static void encode(const int32_t& value, char* buf, int pos) { int32ToNetwork(value, buf, pos); }
+    static void decode(int32_t& value, char* buf, int pos) { value = networkToInt32(buf, pos); }
+};
+
+template <>
+struct field_codec<float> {
+    static constexpr int size = 4;
+    static void encode(const float& value, char* buf, int pos) { floatToNetwork(value, buf, pos); }
+    static void decode(float& value, char* buf, int pos) { value = networkToFloat(buf, pos); }
+};
+
+template <typename U, size_t N>
+struct field_codec<U[N]> {
+    static constexpr int size = N * field_codec<U>::size;
+    static void encode(const U (&value)[N], char* buf, int pos)
+    {
+        for (size_t i = 0; i < N; i++) {
+            field_codec<U>::encode(value[i], buf, pos + i * field_codec<U>::size);
+        }
+    }
+    static void decode(U (&value)[N], char* buf, int pos)
+    {
+        for (size_t i = 0; i < N; i++) {
+            field_codec<U>::decode(value[i], buf, pos + i * field_codec<U>::size);
+        }
+    }
+};
+
+// arrays of 4-byte values are converted in one pass
+template <size_t N>
+struct field_codec<float[N]> {
+    static constexpr int size = N * 4;
+    static void encode(const float (&value)[N], char* buf, int pos) { floatsToNetwork(value, N, buf, pos); }
+    static void decode(float (&value)[N], char* buf, int pos) { networkToFloats(value, N, buf, pos); }
+};
+
+template <size_t N>
+struct field_codec<int32_t[N]> {
+    static constexpr int size = N * 4;
+    static void encode(const int32_t (&value)[N], char* buf, int pos) { int32sToNetwork(value, N, buf, pos); }
+    static void decode(int32_t (&value)[N], char* buf, int pos) { networkToInt32s(value, N, buf, pos); }
+};
+
+/**
+ * @brief  how far apart two values of one type are, used to decide if a changed value is worth sending
+ * For arrays it's the largest difference of any element. NaN if either value is NaN.
+ */
+template <typename U>
+struct field_difference {
+    static float max(const U& a, const U& b)
+    {
+        float difference = (float)a - (float)b;
+        return difference < 0 ? -difference : difference;
+    }
+};
+
+template <typename U, size_t N>
+struct field_difference<U[N]> {
+    static float max(const U (&a)[N], const U (&b)[N])
+    {
+        float result = 0;
+        for (size_t i = 0; i < N; i++) {
+            float difference = field_difference<U>::max(a[i], b[i]);
+            if (!(difference <= result)) { // also keeps NaN
+                result = difference;
+            }
+        }
+        return result;
+    }
+};
+
+/**
+ * @brief  describes one member of a data struct, for example field<&xrp_motor_t::value>
+ */
+template <auto Member>
+struct field;
+
+template <typename T, typename U, U T::*Member>
+struct field<Member> {
+    static constexpr int size = field_codec<U>::size;
+    static void encode(const T& data, char* buf, int pos) { field_codec<U>::encode(data.*Member, buf, pos); }
+    static void decode(T& data, char* buf, int pos) { field_codec<U>::decode(data.*Member, buf, pos); }
+    static float difference(const T& a, const T& b) { return field_difference<U>::max(a.*Member, b.*Member); }
+};
+
+/**
+ * @brief  the members of a data struct in the order they appear in a block (after the size and tag bytes)
+ */
+template <auto... Members>
+struct field_list {
+    static constexpr int size = (0 + ... + field<Members>::size);
+
+    template <typename T>
+    static void encode(const T& data, char* buf, int pos)
+    {
+        ((field<Members>::encode(data, buf, pos), pos += field<Members>::size), ...);
+    }
+
+    template <typename T>
+    static void decode(T& data, char* buf, int pos)
+    {
+        ((field<Members>::decode(data, buf, pos), pos += field<Members>::size), ...);
+    }
+
+    /**
+     * @brief  the largest difference between any field of a and b, NaN if any field is NaN
+     */
+    template <typename T>
+    static float maxDifference(const T& a, const T& b)
+    {
+        float result = 0;
+        ((result = larger(result, field<Members>::difference(a, b))), ...);
+        return result;
+    }
+
+    /**
+     * @brief  where a member is in the block, counted from the first byte after the tag
+     */
+    template <auto Member>
+    static constexpr int offsetOf()
+    {
+        int offset = 0;
+        bool found = false;
+        ((found = found || sameMember<Members, Member>(), offset += found ? 0 : field<Members>::size), ...);
+        return offset;
+    }
+
+private:
+    template <auto A, auto B>
+    static constexpr bool sameMember()
+    {
+        if constexpr (std::is_same<decltype(A), decltype(B)>::value) {
+            return A == B;
+        } else {
+            return false;
+        }
+    }
+
+    static float larger(float result, float difference)
+    {
+        return (difference <= result) ? result : difference; // also keeps NaN
+    }
+};
@@ -17,6 +17,9 @@ template <>
 struct tag_type<xrp_accel_t> {
     static constexpr uint8_t value = XRP_TAG_ACCEL;
     static constexpr bool hasId = false;
+    static constexpr bool receivable = false; // true if wpilib can send it to the robot
+    static constexpr bool sendable = true; // true if the robot can send it to wpilib
+    using fields = field_list<&xrp_accel_t::accels>;
 };
 
 #include "byteutils.h"
@@ -62,9 +65,7 @@ public:
         }
         buffer[pos] = 13; // size excluding size byte itself
         buffer[pos + 1] = XRP_TAG_ACCEL;
-        floatToNetwork(data.x, buffer, pos + 2);
-        floatToNetwork(data.y, buffer, pos + 6);
-        floatToNetwork(data.z, buffer, pos + 10);
+        floatsToNetwork(data.accels, 3, buffer, pos + 2);
         return 14; // 1 for size, 1 for tag, 3 floats (4 bytes each)
     }
     int fromNetworkBuffer(char* buf, int pos, int end) override
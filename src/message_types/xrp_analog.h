@@ -11,6 +11,9 @@ template <>
 struct tag_type<xrp_analog_t> {
     static constexpr uint8_t value = XRP_TAG_ANALOG;
     static constexpr bool hasId = true;
+    static constexpr bool receivable = true; // true if wpilib can send it to the robot
+    static constexpr bool sendable = true; // true if the robot can send it to wpilib
+    using fields = field_list<&xrp_analog_t::id, &xrp_analog_t::value>;
 };
 
 #include "byteutils.h"
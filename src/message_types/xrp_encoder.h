@@ -13,6 +13,9 @@ template <>
 struct tag_type<xrp_encoder_t> {
     static constexpr uint8_t value = XRP_TAG_ENCODER;
     static constexpr bool hasId = true;
+    static constexpr bool receivable = false; // true if wpilib can send it to the robot
+    static constexpr bool sendable = true; // true if the robot can send it to wpilib
+    using fields = field_list<&xrp_encoder_t::id, &xrp_encoder_t::count, &xrp_encoder_t::period, &xrp_encoder_t::divisor>;
 };
 
 #include "byteutils.h"
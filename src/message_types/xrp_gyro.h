@@ -25,6 +25,9 @@ template <>
 struct tag_type<xrp_gyro_t> {
     static constexpr uint8_t value = XRP_TAG_GYRO;
     static constexpr bool hasId = false;
+    static constexpr bool receivable = false; // true if wpilib can send it to the robot
+    static constexpr bool sendable = true; // true if the robot can send it to wpilib
+    using fields = field_list<&xrp_gyro_t::rates, &xrp_gyro_t::angles>;
 };
 
 #include "byteutils.h"
@@ -70,12 +73,8 @@ public:
         }
         buffer[pos] = 25; // size excluding itself
         buffer[pos + 1] = XRP_TAG_GYRO;
-        floatToNetwork(data.rates[0], buffer, pos + 2);
-        floatToNetwork(data.rates[1], buffer, pos + 6);
-        floatToNetwork(data.rates[2], buffer, pos + 10);
-        floatToNetwork(data.angles[0], buffer, pos + 14);
-        floatToNetwork(data.angles[1], buffer, pos + 18);
-        floatToNetwork(data.angles[2], buffer, pos + 22);
+        floatsToNetwork(data.rates, 3, buffer, pos + 2);
+        floatsToNetwork(data.angles, 3, buffer, pos + 14);
         return 26; // 1 for size, 1 for tag, 2*3*4=24 for values
     }
     int fromNetworkBuffer(char* buf, int pos, int end) override
@@ -1,7 +1,7 @@
 #pragma once
 #define XRP_TAG_MOTOR 0x12
 
-#include <Arduino.h>
+#include "message_type.h"
 
 typedef struct {
     uint8_t id;
@@ -12,6 +12,9 @@ template <>
 struct tag_type<xrp_motor_t> {
     static constexpr uint8_t value = XRP_TAG_MOTOR;
     static constexpr bool hasId = true;
+    static constexpr bool receivable = true; // true if wpilib can send it to the robot
+    static constexpr bool sendable = false; // true if the robot can send it to wpilib
+    using fields = field_list<&xrp_motor_t::id, &xrp_motor_t::value>;
 };
 
 #include "byteutils.h"
@@ -0,0 +1,157 @@
+#pragma once
+#include <Arduino.h>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief  Gets every datagram XSWC reads and every telemetry packet it sends, set it with XSWC::setRecorder().
+ * Recordings can be played back on a computer with extras/replay. Each record is stored as:
+ * 1 byte SYNC, 1 byte Direction, 4 bytes micros(), 2 bytes length, then the packet (numbers are big-endian, like in the packets).
+ * Implement this class to store records somewhere else.
+ */
+class PacketRecorder {
+public:
+    enum Direction : uint8_t {
+        RECEIVED = 0, // a datagram from the remote that sends commands (or that became the remote with it), including ones that are then ignored
+        SENT = 1, // a telemetry packet, before it's split into datagrams of MAX_DATAGRAM_SIZE
+        RECEIVED_FROM_OTHER_REMOTE = 2, // a datagram from a different address than the connected remote, it was ignored
+    };
+
+    static constexpr uint8_t SYNC = 0xA5; // first byte of every record, so a recording mixed with other Serial output can be found again
+    static constexpr int HEADER_SIZE = 8;
+
+    virtual ~PacketRecorder() = default;
+
+    /**
+     * @brief  store one packet, called by XSWC in the thread that receives and sends (the communication task if it's running)
+     */
+    virtual void record(Direction direction, uint32_t micros, const char* data, int length) = 0;
+
+    /**
+     * @brief  write the header of a record into header[0] to header[HEADER_SIZE - 1]
+     */
+    static void encodeHeader(uint8_t* header, Direction direction, uint32_t micros, int length)
+    {
+        header[0] = SYNC;
+        header[1] = direction;
+        header[2] = micros >> 24;
+        header[3] = micros >> 16;
+        header[4] = micros >> 8;
+        header[5] = micros;
+        header[6] = length >> 8;
+        header[7] = length;
+    }
+};
+
+/**
+ * @brief  Writes each record as soon as it happens, to Serial or anything else that Print can write to.
+ * @note   at high packet rates this can take longer than the Serial port can keep up with, use RingRecorder then
+ */
+class StreamRecorder : public PacketRecorder {
+public:
+    StreamRecorder(Print& _out)
+        : out(_out)
+    {
+    }
+
+    void record(Direction direction, uint32_t micros, const char* data, int length) override
+    {
+        uint8_t header[HEADER_SIZE];
+        encodeHeader(header, direction, micros, length);
+        out.write(header, HEADER_SIZE);
+        out.write((const uint8_t*)data, length);
+    }
+
+protected:
+    Print& out;
+};
+
+/**
+ * @brief  Keeps the newest records in RAM, the oldest records are dropped when there isn't space for a new one.
+ * Recording only copies memory, so it's fast enough to leave on during a match. Copy the records out with writeTo() afterwards.
+ * @note   only writeTo() while XSWC isn't using the recorder (for example after setRecorder(nullptr))
+ */
+template <size_t Bytes>
+class RingRecorder : public PacketRecorder {
+public:
+    void record(Direction direction, uint32_t micros, const char* data, int length) override
+    {
+        size_t needed = HEADER_SIZE + length;
+        if (needed > Bytes) {
+            dropped++;
+            return;
+        }
+        while (Bytes - used < needed) {
+            size_t oldestLength = ((size_t)byteAt(6) << 8) | byteAt(7);
+            first = (first + HEADER_SIZE + oldestLength) % Bytes;
+            used -= HEADER_SIZE + oldestLength;
+            dropped++;
+        }
+        uint8_t header[HEADER_SIZE];
+        encodeHeader(header, direction, micros, length);
+        append(header, HEADER_SIZE);
+        append((const uint8_t*)data, length);
+    }
+
+    /**
+     * @brief  write every kept record, oldest first, in the same format StreamRecorder writes
+     * @retval (size_t) bytes written
+     */
+    size_t writeTo(Print& out) const
+    {
+        size_t start = first;
+        size_t firstPart = (used < Bytes - start) ? used : Bytes - start;
+        size_t written = out.write(buffer + start, firstPart);
+        if (firstPart < used) {
+            written += out.write(buffer, used - firstPart);
+        }
+        return written;
+    }
+
+    /**
+     * @brief  forget every record
+     */
+    void clear()
+    {
+        first = 0;
+        used = 0;
+        dropped = 0;
+    }
+
+    /**
+     * @brief  how many bytes of records are kept
+     */
+    size_t size() const
+    {
+        return used;
+    }
+
+    /**
+     * @brief  how many records were dropped to make space, or because they were larger than the whole buffer
+     */
+    uint32_t getDropped() const
+    {
+        return dropped;
+    }
+
+protected:
+    uint8_t byteAt(size_t offset) const
+    {
+        return buffer[(first + offset) % Bytes];
+    }
+
+    void append(const uint8_t* data, size_t length)
+    {
+        size_t end = (first + used) % Bytes;
+        for (size_t i = 0; i < length; i++) {
+            buffer[end] = data[i];
+            end = (end + 1 == Bytes) ? 0 : end + 1;
+        }
+        used += length;
+    }
+
+    uint8_t buffer[Bytes];
+    size_t first = 0; // where the oldest record starts
+    size_t used = 0;
+    uint32_t dropped = 0;
+};
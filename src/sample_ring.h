@@ -0,0 +1,76 @@
+#pragma once
+#include <array>
+#include <cstdint>
+
+/**
+ * @brief  Fixed size ring buffer of timestamped samples, the oldest sample is replaced when it's full.
+ * Used to collect sensor readings taken between two telemetry packets. Adding a sample never allocates memory.
+ */
+template <typename T, int Capacity>
+class SampleRing {
+public:
+    struct Sample {
+        uint32_t micros; // when the sample was taken
+        T data;
+    };
+
+    /**
+     * @brief  add a sample
+     * @retval (bool) false if the buffer was full and the oldest sample was replaced
+     */
+    bool push(uint32_t micros, const T& data)
+    {
+        samples[(first + count) % Capacity] = { micros, data };
+        if (count < Capacity) {
+            count++;
+            return true;
+        }
+        first = (first + 1) % Capacity;
+        return false;
+    }
+
+    /**
+     * @brief  the i-th oldest sample, i must be less than size()
+     */
+    const Sample& at(int i) const
+    {
+        return samples[(first + i) % Capacity];
+    }
+
+    int size() const
+    {
+        return count;
+    }
+
+    void clear()
+    {
+        first = 0;
+        count = 0;
+    }
+
+protected:
+    std::array<Sample, Capacity> samples;
+    int first = 0; // index of the oldest sample
+    int count = 0;
+};
+
+/**
+ * @brief  A SampleRing that can't hold any samples and doesn't use memory for them, so sample buffers cost nothing unless they're enabled.
+ */
+template <typename T>
+class SampleRing<T, 0> {
+public:
+    bool push(uint32_t micros, const T& data)
+    {
+        return false;
+    }
+
+    int size() const
+    {
+        return 0;
+    }
+
+    void clear()
+    {
+    }
+};
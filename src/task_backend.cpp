@@ -0,0 +1,104 @@
+#include "task_backend.h"
+
+#if defined(ESP32)
+#include <atomic>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+// FreeRTOS tasks can't be joined, so the task sets a flag just before deleting itself
+class FreeRTOSTaskBackend : public TaskBackend {
+public:
+    FreeRTOSTaskBackend(uint32_t _stackSize, UBaseType_t _priority)
+        : stackSize(_stackSize)
+        , priority(_priority)
+    {
+    }
+
+    bool start(void (*_entry)(void*), void* _arg, int core) override
+    {
+        entry = _entry;
+        arg = _arg;
+        finished = false;
+        BaseType_t coreId = (core < 0) ? tskNO_AFFINITY : core;
+        return xTaskCreatePinnedToCore(run, "xswc", stackSize, this, priority, nullptr, coreId) == pdPASS;
+    }
+
+    void join() override
+    {
+        while (!finished.load(std::memory_order_acquire)) {
+            vTaskDelay(1);
+        }
+    }
+
+protected:
+    static void run(void* self)
+    {
+        FreeRTOSTaskBackend* backend = (FreeRTOSTaskBackend*)self;
+        backend->entry(backend->arg);
+        backend->finished.store(true, std::memory_order_release);
+        vTaskDelete(nullptr);
+    }
+
+    uint32_t stackSize;
+    UBaseType_t priority;
+    void (*entry)(void*) = nullptr;
+    void* arg = nullptr;
+    std::atomic<bool> finished { true };
+};
+
+TaskBackend* defaultTaskBackend()
+{
+    static FreeRTOSTaskBackend backend(4096, 2); // the Arduino loop() task has priority 1
+    return &backend;
+}
+
+#elif !defined(ARDUINO)
+#include <thread>
+#ifdef __linux__
+#include <pthread.h>
+#endif
+
+class StdThreadTaskBackend : public TaskBackend {
+public:
+    bool start(void (*entry)(void*), void* arg, int core) override
+    {
+        if (thread.joinable()) {
+            return false; // already running
+        }
+        thread = std::thread(entry, arg);
+#ifdef __linux__
+        if (core >= 0) {
+            cpu_set_t cpus;
+            CPU_ZERO(&cpus);
+            CPU_SET(core, &cpus);
+            pthread_setaffinity_np(thread.native_handle(), sizeof(cpus), &cpus); // best effort
+        }
+#endif
+        return true;
+    }
+
+    void join() override
+    {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+
+protected:
+    std::thread thread;
+};
+
+TaskBackend* defaultTaskBackend()
+{
+    static StdThreadTaskBackend* backend = new StdThreadTaskBackend(); // never destroyed, so it's still there when the global xswc stops its task at exit
+    return backend;
+}
+
+#else
+
+TaskBackend* defaultTaskBackend()
+{
+    return nullptr;
+}
+
+#endif
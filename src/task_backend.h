@@ -0,0 +1,29 @@
+#pragma once
+
+/**
+ * @brief  Starts and stops the thread that XSWC::beginTask() runs the communication loop in.
+ * A FreeRTOS backend is built in for the ESP32 and a std::thread backend for computers,
+ * implement this class to use a different threading library.
+ */
+class TaskBackend {
+public:
+    virtual ~TaskBackend() = default;
+
+    /**
+     * @brief  start running entry(arg) in a new thread
+     * @param  core: the core to run the thread on, -1 for any core (backends that can't pin threads ignore this)
+     * @retval (bool) true if the thread was started
+     */
+    virtual bool start(void (*entry)(void*), void* arg, int core) = 0;
+
+    /**
+     * @brief  wait until entry has returned, called after the thread has been told to stop
+     */
+    virtual void join() = 0;
+};
+
+/**
+ * @brief  the backend built in for this platform
+ * @retval (TaskBackend*) nullptr if there isn't one
+ */
+TaskBackend* defaultTaskBackend();
@@ -0,0 +1,73 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+/**
+ * @brief  Lock-free handoff of the newest value from one writer thread to one reader thread.
+ * The writer fills writeBuffer() and calls publish(), the reader calls update() and then looks at readBuffer().
+ * Neither side ever waits for the other: there are three copies of T, one owned by each side and one in the middle
+ * that holds the newest published value. Values that the reader doesn't pick up in time are replaced by newer ones.
+ */
+template <typename T>
+class TripleBuffer {
+public:
+    /**
+     * @brief  the buffer the writer fills, only the writer thread may use it
+     */
+    T& writeBuffer()
+    {
+        return buffers[writeIndex];
+    }
+
+    /**
+     * @brief  make the contents of writeBuffer() available to the reader, writeBuffer() then returns a different buffer
+     * @note   the new writeBuffer() holds an older value, not a copy of what was just published
+     * @retval (bool) false if the value published before this one was never read by the reader, it was replaced
+     */
+    bool publish()
+    {
+        uint32_t previous = middle.exchange(writeIndex | NEW_DATA, std::memory_order_acq_rel);
+        writeIndex = previous & INDEX_MASK;
+        return (previous & NEW_DATA) == 0;
+    }
+
+    /**
+     * @brief  switch readBuffer() to the newest published value, only the reader thread may call this
+     * @retval (bool) true if something was published since the last call, false if readBuffer() didn't change
+     */
+    bool update()
+    {
+        if ((middle.load(std::memory_order_relaxed) & NEW_DATA) == 0) {
+            return false;
+        }
+        readIndex = middle.exchange(readIndex, std::memory_order_acq_rel) & INDEX_MASK;
+        return true;
+    }
+
+    /**
+     * @brief  the newest value as of the last update(), only the reader thread may use it
+     */
+    T& readBuffer()
+    {
+        return buffers[readIndex];
+    }
+
+    /**
+     * @brief  set all three buffers, only call this while no other thread is using the TripleBuffer
+     */
+    void fill(const T& value)
+    {
+        for (T& buffer : buffers) {
+            buffer = value;
+        }
+    }
+
+protected:
+    static constexpr uint32_t INDEX_MASK = 0x3;
+    static constexpr uint32_t NEW_DATA = 0x4; // set in middle when the writer published and the reader hasn't taken it yet
+
+    T buffers[3];
+    std::atomic<uint32_t> middle { 1 }; // 32 bits so it's lock-free on every target
+    uint8_t writeIndex = 0;
+    uint8_t readIndex = 2;
+};
@@ -0,0 +1,714 @@
+/**
+ * definitions of BasicXSWC's methods, included at the end of xrp-style-wpilib-comms.h
+ * they're templates so that each configuration of capacities gets its own copy, the default XSWC is compiled once in xrp-style-wpilib-comms.cpp
+ */
+#pragma once
+
+#include "byteutils.h"
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <WiFiMulti.h>
+#include <WiFiUdp.h>
+#include <cstring>
+
+template <int RxSize, int TxSize, int MaxChannelsPerTag, bool SharedBuffer, int MaxSubscribers, int SampleBufferSize, bool MeasureLatency>
+BasicXSWC<RxSize, TxSize, MaxChannelsPerTag, SharedBuffer, MaxSubscribers, SampleBufferSize, MeasureLatency>::BasicXSWC()
+{
+    clearBufferToSend();
+}
+
+template <int RxSize, int TxSize, int MaxChannelsPerTag, bool SharedBuffer, int MaxSubscribers, int SampleBufferSize, bool MeasureLatency>
+BasicXSWC<RxSize, TxSize, MaxChannelsPerTag, SharedBuffer, MaxSubscribers, SampleBufferSize, MeasureLatency>::~BasicXSWC()
+{
+    endTask();
+    delete rxHandlers;
+    delete txChannels;
+}
+
+// getData and sendData (recalling received channels and writing blocks into txBuf) are in the header file
+
+// https://github.com/wpilibsuite/allwpilib/tree/main/simulation/halsim_xrp
+template <int RxSize, int TxSize, int MaxChannelsPerTag, bool SharedBuffer, int MaxSubscribers, int SampleBufferSize, bool MeasureLatency>
+typename BasicXSWC<RxSize, TxSize, MaxChannelsPerTag, SharedBuffer, MaxSubscribers, SampleBufferSize, MeasureLatency>::ParseResult BasicXSWC<RxSize, TxSize, MaxChannelsPerTag, SharedBuffer, MaxSubscribers, SampleBufferSize, MeasureLatency>::processReceivedBufferIntoMessages(char* buffer, int length)
+{
+    if (length < 3) { // too short to contain counter and enabled bit
+        stats.parseShortPackets++;
+        return ParseResult::SHORT_PACKET;
+    }
+    if (!trackSequence(networkToUInt16(buffer, 0))) {
+        return ParseResult::STALE; // don't let an old packet overwrite newer values
+    }
+    return decodePacket(buffer, length);
+}
+
+// decode a packet whose header was already checked, into the table of received channels
+template <int RxSize, int TxSize, int MaxChannelsPerTag, bool SharedBuffer, int MaxSubscribers, int SampleBufferSize, bool MeasureLatency>
+typename BasicXSWC<RxSize, TxSize, MaxChannelsPerTag, SharedBuffer, MaxSubscribers, SampleBufferSize, MeasureLatency>::ParseResult BasicXSWC<RxSize, TxSize, MaxChannelsPerTag, SharedBuffer, MaxSubscribers, SampleBufferSize, MeasureLatency>::decodePacket(char* buffer, int length)
+{
+    int index = 0;
+    uint16_t sequence = networkToUInt16(buffer, 0);
+    millisWhenPacketParsed = clockMillis();
+    cmdEnable = ((uint8_t)buffer[2] == 1);
+    index += 3;
+    indexedBuffer = buffer;
+    ParseResult result = ParseResult::OK;
+    uint32_t unknownTags = 0; // added to stats once, not in the loop
+    while (index + 1 < length) { // min size of a block is 2
+        // process "data blocks" each block is a message
+        int size = (uint8_t)buffer[index] + 1; // size value excludes the size byte
+        if (size <= 1) {
+            stats.parseUnknownTags += unknownTags;
+            stats.parseBadSize++;
+            return ParseResult::BAD_SIZE; // invalid
+        }
+        index++; // size
+        uint8_t tag = (uint8_t)buffer[index];
+        static constexpr std::array<BlockDecoder, XRP_TAG_COUNT> blockDecoders = makeBlockDecoders(xrp_receivable_types());
+        BlockDecoder decoder = nullptr;
+        if (tag >= XRP_TAG_FIRST && tag < XRP_TAG_FIRST + XRP_TAG_COUNT) {
+            decoder = blockDecoders[tag - XRP_TAG_FIRST];
+        }
+        if (decoder == nullptr) {
+            // unknown message type, skip it
+            result = ParseResult::UNKNOWN_TAG;
+            unknownTags++;
+            index += size - 1;
+            continue;
+        }
+        int indexIncrement = (this->*decoder)(buffer, index, length, sequence);
+        index += indexIncrement;
+        if (indexIncrement + 1 != size) { // (+1 is for the size byte itself)
+            stats.parseUnknownTags += unknownTags;
+            stats.parseBadSize++;
+            return ParseResult::BAD_SIZE; // decoding failed
+        }
+    }
+    stats.parseUnknownTags += unknownTags;
+    return result;
+}
+
+// sequence numbers wrap around, so they're compared by their signed difference
+template <int RxSize, int TxSize, int MaxChannelsPerTag, bool SharedBuffer, int MaxSubscribers, int SampleBufferSize, bool MeasureLatency>
+bool BasicXSWC<RxSize, TxSize, MaxChannelsPerTag, SharedBuffer, MaxSubscribers, SampleBufferSize, MeasureLatency>::trackSequence(uint16_t sequence)
+{
+    int16_t diff = (int16_t)(sequence - lastRxSequence);
+    if (!rxSequenceValid || -diff > (int)SEQUENCE_RESYNC_DISTANCE) {
+        // first packet from this remote, or the sender restarted its count
+        rxSequenceValid = true;
+        lastRxSequence = sequence;
+        rxSequenceWindow = 1;
+        return true;
+    }
+    if (diff > 0) { // newer than anything received so far
+        stats.packetsLost += diff - 1;
+        rxSequenceWindow = (diff < 32) ? (rxSequenceWindow << diff) | 1 : 1;
+        lastRxSequence = sequence;
+        return true;
+    }
+    int age = -diff;
+    if (age < 32 && (rxSequenceWindow & (1UL << age)) == 0) {
+        // a packet that was counted as lost arrived late
+        rxSequenceWindow |= (1UL << age);
+        stats.packetsReordered++;
+        if (stats.packetsLost > 0) {
+            stats.packetsLost--;
+        }
+    } else if (age < 32) {
+        stats.packetsDuplicated++;
+    } else {
+        stats.packetsReordered++; // too old to tell if it's a duplicate
+    }
+    return false;
+}
+
+// the blocks were already written into txBuf by sendData, this just fills in the control byte
+template <int RxSize, int TxSize, int MaxChannelsPerTag, bool SharedBuffer, int MaxSubscribers, int SampleBufferSize, bool MeasureLatency>
+int BasicXSWC<RxSize, TxSize, MaxChannelsPerTag, SharedBuffer, MaxSubscribers, SampleBufferSize, MeasureLatency>::processMessagesIntoBufferToSend()
+{
+    txBuffer()[2] = 0; // unset the control byte (the sequence number is filled in by transmit())
+    return txLength;
+}
+
+template <int RxSize, int TxSize, int MaxChannelsPerTag, bool SharedBuffer, int MaxSubscribers, int SampleBufferSize, bool MeasureLatency>
+void BasicXSWC<RxSize, TxSize, MaxChannelsPerTag, SharedBuffer, MaxSubscribers, SampleBufferSize, MeasureLatency>::clearBufferToSend()
+{
+    txLength = 3; // leave space for the sequence number and control byte
+    for (int tag = 0; tag < XRP_TAG_COUNT; tag++) {
+        for (int id = 0; id < MaxChannelsPerTag; id++) {
+            txBlockOffsets[tag][id] = -1;
+        }
+    }
+}
+
+template <int RxSize, int TxSize, int MaxChannelsPerTag, bool SharedBuffer, int MaxSubscribers, int SampleBufferSize, bool MeasureLatency>
+bool BasicXSWC<RxSize, TxSize, MaxChannelsPerTag, SharedBuffer, MaxSubscribers, SampleBufferSize, MeasureLatency>::begin(void (*_receiveCallback)(void), void (*_sendCallback)(void), uint16_t port)
+{
+    // Set the callbacks
+    if (_receiveCallback == nullptr || _sendCallback == nullptr) {
+        return false;
+    }
+    receiveCallback = _receiveCallback;
+    sendCallback = _sendCallback;
+
+    // Set up UDP
+    udp->begin(port);
+
+    if (useAP) {
+        Serial.println("AP started");
+        Serial.printf("[NET] IP: %s\n", WiFi.softAPIP().toString().c_str());
+    } else {
+        Serial.println("Connected to network");
+        Serial.printf("[NET] SSID: %s\n", WiFi.SSID().c_str());
+        Serial.printf("[NET] IP: %s\n", WiFi.localIP().toString().c_str());
+    }
+
+    return true;
+}
+
+template <int RxSize, int TxSize, int MaxChannelsPerTag, bool SharedBuffer, int MaxSubscribers, int SampleBufferSize, bool MeasureLatency>
+bool BasicXSWC<RxSize, TxSize, MaxChannelsPerTag, SharedBuffer, MaxSubscribers, SampleBufferSize, MeasureLatency>::begin(const char* ssid, const char* password, void (*_receiveCallback)(void), void (*_sendCallback)(void), const char* hostname, uint16_t port)
+{
+    if (_receiveCallback == nullptr || _sendCallback == nullptr) {
+        return false;
+    }
+
+    WiFi.setHostname(hostname);
+
+    WiFiMulti multi;
+
+    // TODO: DEBUG why I can't connect to a network
+
+    if (useAP == false) {
+        multi.addAP(ssid, password); // TODO: could be a list, or from a configuration file
+
+        // Attempt to connect
+        if (multi.run() != WL_CONNECTED) {
+            Serial.println("[NET] Failed to connect to any network on list. Falling back to AP");
+            useAP = true;
+        }
+    }
+
+    if (useAP) {
+        WiFi.disconnect();
+        WiFi.mode(WIFI_AP);
+        // TODO: make ap name and password customizable
+        Serial.println("[NET] creating AP with ssid: XRP_XSWC_AP and password: password");
+        WiFi.softAP("XRP_XSWC_AP", "password");
+        while (WiFi.softAPIP() == IPAddress(0, 0, 0, 0)) {
+            Serial.print(".");
+            delay(100); // wait for AP to be ready
+        }
+        Serial.println();
+    }
+
+    return begin(_receiveCallback, _sendCallback, port);
+}
+
+// read every queued packet (up to MAX_PACKETS_PER_UPDATE) and apply them oldest first, this is the part of update() that the communication task runs
+// a channel that's only in an older packet keeps that packet's value, the newest packet decides everything else
+template <int RxSize, int TxSize, int MaxChannelsPerTag, bool SharedBuffer, int MaxSubscribers, int SampleBufferSize, bool MeasureLatency>
+bool BasicXSWC<RxSize, TxSize, MaxChannelsPerTag, SharedBuffer, MaxSubscribers, SampleBufferSize, MeasureLatency>::receivePacket()
+{
+    if (clockMillis() - millisWhenLastMessageReceived >= linkTimeoutMs()) {
+        // reset connection if no messages received for a while
+        if (connectedToRemote) {
+            rxChannels.invalidate(); // don't let the next snapshot for update() bring back stale values
+            cmdEnable = false;
+            // the next remote may send at a different rate
+            commandIntervalMicros = 0;
+            rxInterArrival.reset();
+            rxArrivalValid = false;
+            adaptiveTimeoutMs = ULONG_MAX;
+        }
+        connectedToRemote = false;
+        udpRemoteAddr = IPAddress();
+        udpRemotePort = -1;
+    }
+
+    bool gotPacket = false;
+    bool arrived = false; // a packet from the remote was read, even if it's then ignored
+    for (unsigned int packets = 0; packets < MAX_PACKETS_PER_UPDATE; packets++) {
+        if (!udp->parsePacket()) {
+            break;
+        }
+        if (packets == 0) {
+            microsWhenPacketFound = timingStart();
+        }
+        bool fromRemote = true;
+        if (!connectedToRemote) {
+            udpRemoteAddr = udp->remoteIP();
+            udpRemotePort = udp->remotePort();
+            connectedToRemote = true;
+            rxSequenceValid = false;
+        } else if (udpRemoteAddr != udp->remoteIP() || udpRemotePort != udp->remotePort()) {
+            // ignore packets from other addresses (prevent two devices from sending commands at the same time)
+            stats.packetsFromOtherRemotes++;
+            if (recorder == nullptr) {
+                continue; // not even read
+            }
+            fromRemote = false; // only read so it can be recorded
+        }
+
+        char* buffer = rxBuf;
+        if (buffer == indexedBuffer) {
+            // channels that weren't read yet still point into the buffer, decode them before it's overwritten
+            rxChannels.materialize();
+            indexedBuffer = nullptr;
+        }
+        int length = udp->read(buffer, RxSize);
+        if (recorder != nullptr && length > 0) {
+            recorder->record(fromRemote ? PacketRecorder::RECEIVED : PacketRecorder::RECEIVED_FROM_OTHER_REMOTE, clockMicros(), buffer, length);
+        }
+        if (!fromRemote) {
+            continue;
+        }
+        millisWhenLastMessageReceived = clockMillis();
+        arrived = true;
+        stats.packetsReceived++;
+        if (length > 0) {
+            stats.bytesReceived += length;
+        }
+        if (length < 3) {
+            stats.parseShortPackets++;
+            continue; // too short to contain counter and enabled bit
+        }
+        if (!trackSequence(networkToUInt16(buffer, 0))) {
+            continue; // don't let an old packet overwrite newer values
+        }
+        if (gotPacket) {
+            stats.packetsCoalesced++;
+        }
+        gotPacket = true;
+        decodePacket(buffer, length); // only indexes the blocks, so applying every packet costs little more than the newest
+    }
+    if (arrived) {
+        recordArrival(); // once per update, packets read in the same update would add gaps of almost 0
+    }
+    return gotPacket;
+}
+
+// send a few of the counters on the reserved analog and DIO ids, after sendCallback so they aren't overwritten
+template <int RxSize, int TxSize, int MaxChannelsPerTag, bool SharedBuffer, int MaxSubscribers, int SampleBufferSize, bool MeasureLatency>
+void BasicXSWC<RxSize, TxSize, MaxChannelsPerTag, SharedBuffer, MaxSubscribers, SampleBufferSize, MeasureLatency>::sendStatsTelemetry()
+{
+    Stats current = getStats();
+    uint32_t parseErrors = current.parseShortPackets + current.parseBadSize + current.parseUnknownTags + current.parseIdOutOfRange;
+    uint32_t telemetryDropped = current.telemetryBlocksDropped + current.telemetryBufferFull + current.telemetrySendFailures;
+    uint32_t problems = current.packetsLost + parseErrors + telemetryDropped;
+    const uint32_t floatExact = 0xFFFFFF; // wrap around instead of being rounded by the float
+    sendValue_xrp_analog(STATS_ANALOG_FIRST_ID, current.packetsReceived & floatExact);
+    sendValue_xrp_analog(STATS_ANALOG_FIRST_ID + 1, current.packetsLost & floatExact);
+    sendValue_xrp_analog(STATS_ANALOG_FIRST_ID + 2, parseErrors & floatExact);
+    sendValue_xrp_analog(STATS_ANALOG_FIRST_ID + 3, telemetryDropped & floatExact);
+    sendValue_xrp_dio(STATS_DIO_ID, problems == txProblemsReported); // false for one send after anything went wrong
+    txProblemsReported = problems;
+}
+
+// the timeout used by the side that receives packets, update() uses getTimeoutMs()
+template <int RxSize, int TxSize, int MaxChannelsPerTag, bool SharedBuffer, int MaxSubscribers, int SampleBufferSize, bool MeasureLatency>
+unsigned long BasicXSWC<RxSize, TxSize, MaxChannelsPerTag, SharedBuffer, MaxSubscribers, SampleBufferSize, MeasureLatency>::linkTimeoutMs()
+{
+    if (adaptiveTimeout && adaptiveTimeoutMs < TIMEOUT_MS) {
+        return adaptiveTimeoutMs;
+    }
+    return TIMEOUT_MS;
+}
+
+// measure the time since packets from the remote were last read, and derive the timeout for adaptiveTimeout from it
+template <int RxSize, int TxSize, int MaxChannelsPerTag, bool SharedBuffer, int MaxSubscribers, int SampleBufferSize, bool MeasureLatency>
+void BasicXSWC<RxSize, TxSize, MaxChannelsPerTag, SharedBuffer, MaxSubscribers, SampleBufferSize, MeasureLatency>::recordArrival()
+{
+    unsigned long now = clockMicros();
+    unsigned long gap = now - microsWhenLastArrival;
+    bool measured = rxArrivalValid && gap / 1000 < TIMEOUT_MS; // longer gaps are lost links, not jitter
+    microsWhenLastArrival = now;
+    rxArrivalValid = true;
+    if (!measured) {
+        return;
+    }
+    rxInterArrival.record(gap);
+    commandIntervalMicros = (commandIntervalMicros == 0) ? gap : (commandIntervalMicros * 7 + gap) / 8;
+    unsigned long gapTimeoutMs = (unsigned long)(ADAPTIVE_TIMEOUT_FACTOR * gap / 1000) + 1;
+    if (adaptiveTimeoutMs != ULONG_MAX && gapTimeoutMs > adaptiveTimeoutMs) {
+        adaptiveTimeoutMs = gapTimeoutMs; // the sender slowed down, follow it before it times out instead of waiting for the window to end
+    }
+    if (rxInterArrival.getCount() >= ADAPTIVE_TIMEOUT_WINDOW) {
+        adaptiveTimeoutMs = (unsigned long)(ADAPTIVE_TIMEOUT_FACTOR * rxInterArrival.percentile(0.99f) / 1000) + 1; // rounded up
+        rxInterArrival.reset(); // start a new window, so the timeout follows changes in the link
+    }
+    if (adaptiveTimeoutMs < MIN_TIMEOUT_MS) {
+        adaptiveTimeoutMs = MIN_TIMEOUT_MS;
+    }
+}
+
+// forget the received values and call the timeout callback as soon as the link is lost, runs in update()
+template <int RxSize, int TxSize, int MaxChannelsPerTag, bool SharedBuffer, int MaxSubscribers, int SampleBufferSize, bool MeasureLatency>
+void BasicXSWC<RxSize, TxSize, MaxChannelsPerTag, SharedBuffer, MaxSubscribers, SampleBufferSize, MeasureLatency>::checkLinkTimeout()
+{
+    bool connected = isConnected();
+    if (linkUp && !connected) {
+        userChannels().invalidate();
+        if (task != nullptr) {
+            task->commands.readBuffer().cmdEnable = false; // the task clears its own copy when it notices the timeout
+        } else {
+            cmdEnable = false;
+        }
+        linkTimeouts++;
+        if (timeoutCallback != nullptr) {
+            timeoutCallback();
+        }
+    }
+    linkUp = connected;
+}
+
+template <int RxSize, int TxSize, int MaxChannelsPerTag, bool SharedBuffer, int MaxSubscribers, int SampleBufferSize, bool MeasureLatency>
+bool BasicXSWC<RxSize, TxSize, MaxChannelsPerTag, SharedBuffer, MaxSubscribers, SampleBufferSize, MeasureLatency>::isTimeToSend(bool gotPacket)
+{
+    unsigned long millisSinceSent = clockMillis() - millisWhenLastSent;
+    if (txPolicy == TX_REPLY_ON_RECEIVE) {
+        // reply right after a command was processed, and send a heartbeat if commands stop arriving
+        return (gotPacket && millisSinceSent >= MIN_REPLY_SPACING_MS) || millisSinceSent > HEARTBEAT_MS;
+    }
+    if (adaptiveTelemetryRate) {
+        return millisSinceSent >= telemetryIntervalMs;
+    }
+    return millisSinceSent > MIN_UPDATE_TIME_MS;
+}
+
+// called once per send with adaptiveTelemetryRate: follow the command rate, double the interval if packets were lost or
+// couldn't be sent since the last send, and then come back to the command rate gradually
+template <int RxSize, int TxSize, int MaxChannelsPerTag, bool SharedBuffer, int MaxSubscribers, int SampleBufferSize, bool MeasureLatency>
+void BasicXSWC<RxSize, TxSize, MaxChannelsPerTag, SharedBuffer, MaxSubscribers, SampleBufferSize, MeasureLatency>::adaptTelemetryInterval()
+{
+    Stats current = getStats();
+    bool congested = current.packetsLost > txLostSeen || current.telemetrySendFailures > txFailuresSeen;
+    txLostSeen = current.packetsLost;
+    txFailuresSeen = current.telemetrySendFailures;
+
+    unsigned long target = MIN_UPDATE_TIME_MS;
+    unsigned long intervalMicros = (task != nullptr) ? task->commands.readBuffer().commandIntervalMicros : commandIntervalMicros;
+    if (isConnected() && intervalMicros > 0) {
+        target = (intervalMicros + 500) / 1000;
+    }
+    if (target < MIN_TELEMETRY_INTERVAL_MS) {
+        target = MIN_TELEMETRY_INTERVAL_MS;
+    }
+    if (target > MAX_TELEMETRY_INTERVAL_MS) {
+        target = MAX_TELEMETRY_INTERVAL_MS;
+    }
+
+    if (congested) {
+        telemetryIntervalMs = (telemetryIntervalMs < target ? target : telemetryIntervalMs) * 2;
+        if (telemetryIntervalMs > MAX_TELEMETRY_INTERVAL_MS) {
+            telemetryIntervalMs = MAX_TELEMETRY_INTERVAL_MS;
+        }
+    } else if (telemetryIntervalMs > target) {
+        telemetryIntervalMs -= (telemetryIntervalMs - target) / 8 + 1;
+    } else {
+        telemetryIntervalMs = target;
+    }
+}
+
+template <int RxSize, int TxSize, int MaxChannelsPerTag, bool SharedBuffer, int MaxSubscribers, int SampleBufferSize, bool MeasureLatency>
+bool BasicXSWC<RxSize, TxSize, MaxChannelsPerTag, SharedBuffer, MaxSubscribers, SampleBufferSize, MeasureLatency>::update()
+{
+    if (task != nullptr) {
+        return updateWithTask();
+    }
+
+    checkLinkTimeout(); // before receiving, so a packet that arrives after a timeout still triggers the callback first
+    bool gotPacket = receivePacket();
+    if (gotPacket) {
+        linkUp = true;
+        timingRecord(LATENCY_RECEIVE_TO_CALLBACK, microsWhenPacketFound);
+        unsigned long microsBeforeReceiveCallback = timingStart();
+        receiveCallback();
+        timingRecord(LATENCY_RECEIVE_CALLBACK, microsBeforeReceiveCallback);
+    }
+
+    if (isTimeToSend(gotPacket)) {
+        sendTelemetry();
+    }
+
+    return gotPacket;
+}
+
+// run sendCallback and finish the packet in txBuf
+template <int RxSize, int TxSize, int MaxChannelsPerTag, bool SharedBuffer, int MaxSubscribers, int SampleBufferSize, bool MeasureLatency>
+int BasicXSWC<RxSize, TxSize, MaxChannelsPerTag, SharedBuffer, MaxSubscribers, SampleBufferSize, MeasureLatency>::collectTelemetry()
+{
+    millisWhenLastSent = clockMillis();
+    if (adaptiveTelemetryRate) {
+        adaptTelemetryInterval();
+    }
+
+    bool connected = isConnected();
+    txKeyframe = (txSendsSinceKeyframe + 1 >= TELEMETRY_KEYFRAME_INTERVAL) || (connected && !txWasConnected) || txResendAll;
+    txResendAll = false;
+    txSendsSinceKeyframe = txKeyframe ? 0 : txSendsSinceKeyframe + 1;
+    txWasConnected = connected;
+
+    unsigned long microsBeforeSendCallback = timingStart();
+    sendCallback();
+    timingRecord(LATENCY_SEND_CALLBACK, microsBeforeSendCallback);
+    unsigned long microsBeforeSerialize = timingStart();
+    if (reportStats) {
+        sendStatsTelemetry();
+    }
+    appendSampleBatches(encoderSamples);
+    appendSampleBatches(gyroSamples);
+    int txSize = processMessagesIntoBufferToSend();
+    timingRecord(LATENCY_SERIALIZE, microsBeforeSerialize);
+    return txSize;
+}
+
+template <int RxSize, int TxSize, int MaxChannelsPerTag, bool SharedBuffer, int MaxSubscribers, int SampleBufferSize, bool MeasureLatency>
+void BasicXSWC<RxSize, TxSize, MaxChannelsPerTag, SharedBuffer, MaxSubscribers, SampleBufferSize, MeasureLatency>::sendTelemetry()
+{
+    int txSize = collectTelemetry();
+    unsigned long microsBeforeEndPacket = timingStart();
+    if (transmit(txBuffer(), txSize)) {
+        commitSentValues(xrp_sendable_types(), txBuffer());
+    }
+    timingRecord(LATENCY_END_PACKET, microsBeforeEndPacket);
+    clearBufferToSend();
+}
+
+// send a finished packet to the remote and the telemetry subscribers, the sequence number is written into the header here
+// every destination gets the same datagrams with the same sequence numbers, the packet is only serialized once
+// returns false if there's nowhere to send it or a datagram to the remote couldn't be sent, subscribers don't change it
+template <int RxSize, int TxSize, int MaxChannelsPerTag, bool SharedBuffer, int MaxSubscribers, int SampleBufferSize, bool MeasureLatency>
+bool BasicXSWC<RxSize, TxSize, MaxChannelsPerTag, SharedBuffer, MaxSubscribers, SampleBufferSize, MeasureLatency>::transmit(char* buffer, int length)
+{
+    if (!connectedToRemote && subscriberCount == 0) {
+        return false;
+    }
+    bool delivered = true;
+    if (recorder != nullptr) {
+        uint16ToNetwork(txSeq, buffer); // the sequence number of the first datagram
+        recorder->record(PacketRecorder::SENT, clockMicros(), buffer, length);
+    }
+    int limit = MAX_DATAGRAM_SIZE;
+    bool split = length > limit;
+    // if it's too large for one datagram, each datagram gets its own header followed by some of the blocks
+    char header[3];
+    header[2] = buffer[2];
+    int datagrams = 1; // known after packing the first datagram
+    for (int datagram = 0; datagram < datagrams; datagram++) {
+        uint16ToNetwork(txSeq, split ? header : buffer);
+        for (int destination = connectedToRemote ? -1 : 0; destination < subscriberCount; destination++) {
+            if (destination < 0) {
+                udp->beginPacket(udpRemoteAddr, udpRemotePort);
+            } else if (connectedToRemote && subscribers[destination].address == udpRemoteAddr && subscribers[destination].port == udpRemotePort) {
+                continue; // already sent to it as the remote
+            } else {
+                udp->beginPacket(subscribers[destination].address, subscribers[destination].port);
+            }
+            int written; // bytes in this datagram
+            if (split) {
+                udp->write((uint8_t*)header, 3);
+                written = 3;
+                datagrams = packBlocks(buffer, length, limit, datagram, datagram == 0 && destination == (connectedToRemote ? -1 : 0), written);
+            } else {
+                udp->write((uint8_t*)buffer, length);
+                written = length;
+            }
+            if (udp->endPacket()) {
+                stats.packetsSent++;
+                stats.bytesSent += written; // only datagrams that were sent
+            } else if (destination < 0) {
+                stats.telemetrySendFailures++; // for example the network stack is out of buffers
+                delivered = false;
+            } else {
+                stats.subscriberSendFailures++; // a subscriber that can't be reached doesn't slow down or resend the remote's telemetry
+            }
+        }
+        txSeq++;
+    }
+    if (split) {
+        stats.telemetryFramesSplit++;
+        stats.telemetryExtraDatagrams += datagrams - 1;
+    }
+    return delivered;
+}
+
+// first-fit packing of the blocks in buffer into datagrams of at most limit bytes (header included)
+// writes the blocks that end up in the given datagram and adds their bytes to written, returns how many datagrams are needed
+// packing is repeated for each datagram (and destination) instead of remembered, so it needs no extra memory
+template <int RxSize, int TxSize, int MaxChannelsPerTag, bool SharedBuffer, int MaxSubscribers, int SampleBufferSize, bool MeasureLatency>
+int BasicXSWC<RxSize, TxSize, MaxChannelsPerTag, SharedBuffer, MaxSubscribers, SampleBufferSize, MeasureLatency>::packBlocks(const char* buffer, int length, int limit, int datagram, bool countDropped, int& written)
+{
+    int fill[MAX_DATAGRAMS_PER_FRAME];
+    int used = 0;
+    int blockSize;
+    for (int index = 3; index + 1 < length; index += blockSize) {
+        blockSize = (uint8_t)buffer[index] + 1; // size value excludes the size byte
+        int bin = 0;
+        while (bin < used && fill[bin] + blockSize > limit) {
+            bin++;
+        }
+        if (bin == used) {
+            if (used == MAX_DATAGRAMS_PER_FRAME || 3 + blockSize > limit) {
+                if (countDropped) { // only count once per frame
+                    stats.telemetryBlocksDropped++;
+                }
+                continue;
+            }
+            fill[used++] = 3; // header
+        }
+        fill[bin] += blockSize;
+        if (bin == datagram) {
+            udp->write((const uint8_t*)buffer + index, blockSize);
+            written += blockSize;
+        }
+    }
+    return used > 0 ? used : 1; // the header is sent even if every block was dropped
+}
+
+// update() while the communication task is running: pick up what the task received, run the callbacks, and hand telemetry back to the task
+template <int RxSize, int TxSize, int MaxChannelsPerTag, bool SharedBuffer, int MaxSubscribers, int SampleBufferSize, bool MeasureLatency>
+bool BasicXSWC<RxSize, TxSize, MaxChannelsPerTag, SharedBuffer, MaxSubscribers, SampleBufferSize, MeasureLatency>::updateWithTask()
+{
+    bool gotPacket = task->commands.update();
+    checkLinkTimeout();
+    if (gotPacket) {
+        dispatchHandlers(task->commands.readBuffer().channels);
+        unsigned long microsBeforeReceiveCallback = timingStart();
+        receiveCallback();
+        timingRecord(LATENCY_RECEIVE_CALLBACK, microsBeforeReceiveCallback);
+    }
+
+    if (isTimeToSend(gotPacket)) {
+        if (task->telemetryUndelivered.exchange(false, std::memory_order_relaxed)) {
+            txResendAll = true;
+        }
+        TelemetryFrame& frame = task->telemetry.writeBuffer();
+        frame.length = collectTelemetry();
+        memcpy(frame.data, txBuffer(), frame.length);
+        // the task sends it later, so its values count as sent now, and a frame that isn't sent makes the next one a keyframe
+        commitSentValues(xrp_sendable_types(), txBuffer());
+        if (!task->telemetry.publish()) {
+            txResendAll = true; // the task didn't pick up the previous frame in time, it was replaced by this one
+        }
+        clearBufferToSend();
+    }
+
+    return gotPacket;
+}
+
+// copy everything update() and the getters need out of the task's state
+template <int RxSize, int TxSize, int MaxChannelsPerTag, bool SharedBuffer, int MaxSubscribers, int SampleBufferSize, bool MeasureLatency>
+void BasicXSWC<RxSize, TxSize, MaxChannelsPerTag, SharedBuffer, MaxSubscribers, SampleBufferSize, MeasureLatency>::publishCommands()
+{
+    rxChannels.materialize(); // the task reuses its buffers while update() reads the snapshot
+    CommandSnapshot& snapshot = task->commands.writeBuffer();
+    snapshot.channels = rxChannels;
+    snapshot.cmdEnable = cmdEnable;
+    snapshot.millisWhenLastMessageReceived = millisWhenLastMessageReceived;
+    snapshot.adaptiveTimeoutMs = adaptiveTimeoutMs;
+    snapshot.commandIntervalMicros = commandIntervalMicros;
+    snapshot.stats = stats;
+    task->commands.publish();
+}
+
+template <int RxSize, int TxSize, int MaxChannelsPerTag, bool SharedBuffer, int MaxSubscribers, int SampleBufferSize, bool MeasureLatency>
+void BasicXSWC<RxSize, TxSize, MaxChannelsPerTag, SharedBuffer, MaxSubscribers, SampleBufferSize, MeasureLatency>::taskLoop()
+{
+    while (task->running.load(std::memory_order_acquire)) {
+        if (receivePacket()) {
+            publishCommands();
+        }
+        if (task->telemetry.update()) {
+            TelemetryFrame& frame = task->telemetry.readBuffer();
+            if (!transmit(frame.data, frame.length)) {
+                task->telemetryUndelivered.store(true, std::memory_order_relaxed);
+            }
+        }
+        delay(TASK_PERIOD_MS);
+    }
+}
+
+template <int RxSize, int TxSize, int MaxChannelsPerTag, bool SharedBuffer, int MaxSubscribers, int SampleBufferSize, bool MeasureLatency>
+void BasicXSWC<RxSize, TxSize, MaxChannelsPerTag, SharedBuffer, MaxSubscribers, SampleBufferSize, MeasureLatency>::taskEntry(void* self)
+{
+    ((BasicXSWC*)self)->taskLoop();
+}
+
+template <int RxSize, int TxSize, int MaxChannelsPerTag, bool SharedBuffer, int MaxSubscribers, int SampleBufferSize, bool MeasureLatency>
+bool BasicXSWC<RxSize, TxSize, MaxChannelsPerTag, SharedBuffer, MaxSubscribers, SampleBufferSize, MeasureLatency>::beginTask(int core, TaskBackend* backend)
+{
+    if (SharedBuffer || task != nullptr || backend == nullptr) {
+        return false; // with SharedBuffer the task would receive into the buffer update() queues telemetry in
+    }
+    task = new TaskState();
+    task->backend = backend;
+    task->running = true;
+    task->telemetryUndelivered = false;
+
+    // start both sides from the current state, so update() doesn't see an empty snapshot before the first packet
+    rxChannels.materialize();
+    CommandSnapshot snapshot;
+    snapshot.channels = rxChannels;
+    snapshot.cmdEnable = cmdEnable;
+    snapshot.millisWhenLastMessageReceived = millisWhenLastMessageReceived;
+    snapshot.adaptiveTimeoutMs = adaptiveTimeoutMs;
+    snapshot.commandIntervalMicros = commandIntervalMicros;
+    snapshot.stats = stats;
+    task->commands.fill(snapshot);
+    task->telemetry.writeBuffer().length = 0;
+
+    if (!backend->start(taskEntry, this, core)) {
+        delete task;
+        task = nullptr;
+        return false;
+    }
+    return true;
+}
+
+template <int RxSize, int TxSize, int MaxChannelsPerTag, bool SharedBuffer, int MaxSubscribers, int SampleBufferSize, bool MeasureLatency>
+void BasicXSWC<RxSize, TxSize, MaxChannelsPerTag, SharedBuffer, MaxSubscribers, SampleBufferSize, MeasureLatency>::endTask()
+{
+    if (task == nullptr) {
+        return;
+    }
+    task->running.store(false, std::memory_order_release);
+    task->backend->join();
+    delete task;
+    task = nullptr;
+}
+
+template <int RxSize, int TxSize, int MaxChannelsPerTag, bool SharedBuffer, int MaxSubscribers, int SampleBufferSize, bool MeasureLatency>
+unsigned long BasicXSWC<RxSize, TxSize, MaxChannelsPerTag, SharedBuffer, MaxSubscribers, SampleBufferSize, MeasureLatency>::getTimeoutMs()
+{
+    unsigned long measured = (task != nullptr) ? task->commands.readBuffer().adaptiveTimeoutMs : adaptiveTimeoutMs;
+    if (adaptiveTimeout && measured < TIMEOUT_MS) {
+        return measured;
+    }
+    return TIMEOUT_MS;
+}
+
+template <int RxSize, int TxSize, int MaxChannelsPerTag, bool SharedBuffer, int MaxSubscribers, int SampleBufferSize, bool MeasureLatency>
+bool BasicXSWC<RxSize, TxSize, MaxChannelsPerTag, SharedBuffer, MaxSubscribers, SampleBufferSize, MeasureLatency>::isConnected()
+{
+    if (task != nullptr) {
+        return clockMillis() - task->commands.readBuffer().millisWhenLastMessageReceived < getTimeoutMs();
+    }
+    // connectedToRemote is cleared with the adaptive measurement, so the longer TIMEOUT_MS doesn't bring a lost link back
+    return connectedToRemote && clockMillis() - millisWhenLastMessageReceived < getTimeoutMs();
+}
+
+template <int RxSize, int TxSize, int MaxChannelsPerTag, bool SharedBuffer, int MaxSubscribers, int SampleBufferSize, bool MeasureLatency>
+bool BasicXSWC<RxSize, TxSize, MaxChannelsPerTag, SharedBuffer, MaxSubscribers, SampleBufferSize, MeasureLatency>::isEnabled()
+{
+    if (task != nullptr) {
+        return task->commands.readBuffer().cmdEnable;
+    }
+    return cmdEnable;
+}
+
+template <int RxSize, int TxSize, int MaxChannelsPerTag, bool SharedBuffer, int MaxSubscribers, int SampleBufferSize, bool MeasureLatency>
+bool BasicXSWC<RxSize, TxSize, MaxChannelsPerTag, SharedBuffer, MaxSubscribers, SampleBufferSize, MeasureLatency>::isConnectedAndEnabled()
+{
+    return isConnected() && isEnabled();
+}
@@ -3,61 +3,187 @@
  */
 #pragma once
 
-// add includes when you add new message types
-#include "message_types/xrp_accel.h"
-#include "message_types/xrp_analog.h"
-#include "message_types/xrp_dio.h"
-#include "message_types/xrp_encoder.h"
-#include "message_types/xrp_gyro.h"
-#include "message_types/xrp_motor.h"
-#include "message_types/xrp_servo.h"
+#if __cplusplus < 201703L
+#error "xrp-style-wpilib-comms needs C++17, set the compiler to -std=gnu++17 (see the readme for ESP32 Arduino core 2.x and the Arduino IDE)"
+#endif
+
+#include "latency_histogram.h"
+#include "message_registry.h"
+#include "packet_recorder.h"
+#include "sample_ring.h"
+#include "task_backend.h"
+#include "triple_buffer.h"
 
 #include <Arduino.h>
+#include <Udp.h>
 #include <WiFi.h>
 #include <WiFiUdp.h>
+#include <array>
+#include <atomic>
+#include <climits>
 #include <cstdint>
-#include <vector>
-
-#include "message_type.h"
+#include <tuple>
 
 #define UDP_PACKET_MAX_SIZE_XRP 1000 // I think the rpi pico xrp firmware uses 8192, but that's absurdly large
 
+#ifndef XSWC_TX_BUFFER_SIZE
+#define XSWC_TX_BUFFER_SIZE UDP_PACKET_MAX_SIZE_XRP // telemetry queued by sendData each send, if it's raised the telemetry is split into datagrams of up to MAX_DATAGRAM_SIZE bytes
+#endif
+
+#define XSWC_TAG_SAMPLE_BATCH 0x80 // not an XRP tag, wpilib skips blocks with tags it doesn't know by their size byte
+
+#ifndef XSWC_MAX_CHANNELS_PER_TAG
+#define XSWC_MAX_CHANNELS_PER_TAG 16 // IDs below this are tracked in tables, so looking up a received channel or replacing a block to send takes constant time
+#endif
+
 /**
  * @brief  top level class for the XRP-style WPILib communications
  * This class handles the UDP communication, message parsing, and data retrieval/sending.
+ * XSWC is this class with the default capacities, use BasicXSWC directly to choose them at compile time:
+ * @param  RxSize: largest packet that can be received, in bytes
+ * @param  TxSize: telemetry that can be queued for one send, in bytes (it's split into datagrams of MAX_DATAGRAM_SIZE)
+ * @param  MaxChannelsPerTag: IDs below this are tracked in tables, larger IDs can be sent but not received
+ * @param  SharedBuffer: true to receive into the same buffer that telemetry is queued in, which saves RAM but means
+ *         the sendData methods must only be called from the send callback, and beginTask() can't be used
+ * @param  MaxSubscribers: addresses that can get a copy of the telemetry besides the remote that sends commands, see addTelemetrySubscriber
+ * @param  SampleBufferSize: samples of each type (encoder, gyro) kept between sends for sendSampleBatches, 0 doesn't reserve memory for them
+ * @param  MeasureLatency: true to measure how long each part of update() takes, see getLatencyStats
  */
-class XSWC {
+template <int RxSize = UDP_PACKET_MAX_SIZE_XRP, int TxSize = XSWC_TX_BUFFER_SIZE, int MaxChannelsPerTag = XSWC_MAX_CHANNELS_PER_TAG, bool SharedBuffer = false, int MaxSubscribers = 4, int SampleBufferSize = 0, bool MeasureLatency = false>
+class BasicXSWC {
 protected:
     /**
-     * @brief  Factory class to create message types based on their tag.
+     * @brief  The last value received for one channel (one tag and id)
+     * This is only used internally by the XSWC class
+     */
+    template <typename T>
+    struct ChannelState {
+        T data; // only up to date if raw is nullptr
+        char* raw; // the block's tag in a received packet, if it hasn't been decoded into data yet
+        unsigned long millisWhenReceived; // clockMillis() when the block was parsed
+        uint16_t sequence; // sequence number of the packet the block came in
+        uint16_t updates; // counts blocks received for this channel, so update() can tell which channels a snapshot from the communication task changed
+        bool received; // false until a block for this channel has been received
+
+        // decode the block from the received packet, if that hasn't happened yet
+        void materialize()
+        {
+            if (raw != nullptr) {
+                codec<T>::decode(data, raw, 0, codec<T>::blockSize - 1);
+                raw = nullptr;
+            }
+        }
+    };
+
+    /**
+     * @brief  The last value sent for one channel, for deltaTelemetry
+     * This is only used internally by the XSWC class
+     */
+    template <typename T>
+    struct SentState {
+        T data;
+        float deadband = -1; // negative to use TELEMETRY_DEADBAND
+        bool sent = false; // false until a block for this channel has been sent
+    };
+
+    /**
+     * @brief  A function registered for one channel with onReceive or bind
+     * This is only used internally by the XSWC class
+     */
+    template <typename T>
+    struct ChannelHandler {
+        void (*handler)(const T& data, void* context); // nullptr if nothing is registered
+        void* context;
+        uint16_t updates; // ChannelState::updates when the handler was last called
+    };
+
+    /**
+     * @brief  Persistent table of the last value received on each channel, indexed by tag and id.
+     * Values stay readable until they are overwritten, even if a packet doesn't include them.
+     * There is one array of channels for each type in the type_list, types without an id (gyro, accel) only have one channel.
+     * Entry is what's stored for each channel, ChannelState unless it's the table of handlers or of sent values.
      * This is only used internally by the XSWC class
      */
-    class MessageTypeFactory {
+    template <typename List, template <typename> class Entry = ChannelState>
+    class ChannelTable;
+
+    template <typename... Ts, template <typename> class Entry>
+    class ChannelTable<type_list<Ts...>, Entry> {
     public:
-        static MessageType* createMessageType(uint8_t tag)
+        /**
+         * @brief  how many channels of type T are stored, ids from 0 to size() - 1
+         */
+        template <typename T>
+        static constexpr int size()
+        {
+            return HAS_ID(T) ? MaxChannelsPerTag : 1;
+        }
+
+        /**
+         * @brief  get the state of a channel
+         * @retval (Entry<T>*) nullptr if the id is too large to be stored
+         */
+        template <typename T>
+        Entry<T>* find(uint8_t id)
         {
-            // add cases when you add new message types
-            switch (tag) {
-            case XRP_TAG_MOTOR:
-                return new XrpMotor();
-            case XRP_TAG_SERVO:
-                return new XrpServo();
-            case XRP_TAG_DIO:
-                return new XrpDio();
-            case XRP_TAG_ANALOG:
-                return new XrpAnalog();
-            case XRP_TAG_GYRO:
-                return new XrpGyro();
-            case XRP_TAG_ACCEL:
-                return new XrpAccel();
-            case XRP_TAG_ENCODER:
-                return new XRPEncoder();
-            default:
+            if (id >= size<T>()) {
                 return nullptr;
             }
+            return &std::get<Channels<T>>(channels)[id];
+        }
+
+        /**
+         * @brief  decode every channel that still points into a received packet, before the packet's buffer is reused
+         */
+        void materialize()
+        {
+            (materialize(std::get<Channels<Ts>>(channels)), ...);
         }
+
+        /**
+         * @brief  forget every received value, as if nothing had been received
+         */
+        void invalidate()
+        {
+            (invalidate(std::get<Channels<Ts>>(channels)), ...);
+        }
+
+    protected:
+        template <typename T>
+        using Channels = std::array<Entry<T>, size<T>()>;
+
+        template <typename T>
+        static void materialize(Channels<T>& states)
+        {
+            for (Entry<T>& state : states) {
+                state.materialize();
+            }
+        }
+
+        template <typename T>
+        static void invalidate(Channels<T>& states)
+        {
+            for (Entry<T>& state : states) {
+                state.raw = nullptr;
+                state.received = false;
+            }
+        }
+
+        std::tuple<Channels<Ts>...> channels = {};
     };
 
+    // checks one block and records where it is in the table of received channels, see decodeBlockIntoChannel
+    typedef int (BasicXSWC::*BlockDecoder)(char* buffer, int index, int length, uint16_t sequence);
+
+    // builds a table of decoders indexed by tag - XRP_TAG_FIRST, tags that can't be received are nullptr
+    template <typename... Ts>
+    static constexpr std::array<BlockDecoder, XRP_TAG_COUNT> makeBlockDecoders(type_list<Ts...>)
+    {
+        std::array<BlockDecoder, XRP_TAG_COUNT> decoders = {};
+        ((decoders[TYPE_TO_TAG_VAL(Ts) - XRP_TAG_FIRST] = &BasicXSWC::decodeBlockIntoChannel<Ts>), ...);
+        return decoders;
+    }
+
 public:
     // methods to receive data (add methods when you add new message types)
 
@@ -65,7 +191,7 @@ public:
      * @brief  Retrieves data for a specific motor by ID.
      * @param  data: a reference to an xrp_motor_t structure to fill with data
      * @param  id: the ID of the motor
-     * @retval (bool) true if data was found, false otherwise
+     * @retval (bool) true if data has been received for this ID (it may be from an earlier packet, see getAge), false otherwise
      */
     bool getData_xrp_motor(xrp_motor_t& data, const uint8_t id)
     {
@@ -84,11 +210,56 @@ public:
             return data.value;
         return 0.0f;
     }
+    /**
+     * @brief  How long ago data for a specific motor was received.
+     * @note   Use this to stop an output if its value hasn't been updated recently.
+     * @param  id: the ID of the motor
+     * @retval (unsigned long) milliseconds since the motor's data was last received, or ULONG_MAX if it never was
+     */
+    unsigned long getAge_xrp_motor(const uint8_t id)
+    {
+        return getAge<xrp_motor_t>(id);
+    }
+    /**
+     * @brief  Retrieves the values of several motors with consecutive IDs in one call.
+     * @note   Motors that haven't been received are set to 0.0.
+     * @param  values: an array to fill, values[i] is the motor with ID firstId + i
+     * @param  count: the number of elements in values
+     * @param  firstId: the ID of the motor that goes in values[0], default 0
+     * @retval (int) how many of the motors have been received
+     */
+    int getValues_xrp_motor(float* values, int count, uint8_t firstId = 0)
+    {
+        return getValues<xrp_motor_t>(values, count, firstId, 0.0f, [](const xrp_motor_t& data) { return data.value; });
+    }
+    /**
+     * @brief  Call a function each time data for a specific motor is received, as soon as its block is parsed (before the receive callback).
+     * @note   After beginTask(), it's called from update() instead, for each motor that was received since the last update().
+     * @param  id: the ID of the motor
+     * @param  handler: the function to call, nullptr to stop calling a function
+     * @param  context: passed to handler, for example a pointer to an object
+     * @retval (bool) false if the ID is too large to be received
+     */
+    bool onReceive_xrp_motor(const uint8_t id, void (*handler)(const xrp_motor_t& data, void* context), void* context = nullptr)
+    {
+        return setHandler<xrp_motor_t>(id, handler, context);
+    }
+    /**
+     * @brief  Write the value of a specific motor into a variable each time it's received, as soon as its block is parsed (before the receive callback).
+     * @note   After beginTask(), it's written by update() instead. Use onReceive_xrp_motor(id, nullptr) to stop writing it.
+     * @param  id: the ID of the motor
+     * @param  value: the variable to write, it must stay valid until the binding is removed
+     * @retval (bool) false if the ID is too large to be received
+     */
+    bool bind_xrp_motor(const uint8_t id, float& value)
+    {
+        return setHandler<xrp_motor_t>(id, [](const xrp_motor_t& data, void* variable) { *(float*)variable = data.value; }, &value);
+    }
     /**
      * @brief  Retrieves data for a specific servo by ID.
      * @param  data: a reference to an xrp_servo_t structure to fill with data
      * @param  id: the ID of the servo
-     * @retval (bool) true if data was found, false otherwise
+     * @retval (bool) true if data has been received for this ID (it may be from an earlier packet, see getAge), false otherwise
      */
     bool getData_xrp_servo(xrp_servo_t& data, const uint8_t id)
     {
@@ -107,11 +278,56 @@ public:
             return data.value;
         return 0.0f;
     }
+    /**
+     * @brief  How long ago data for a specific servo was received.
+     * @note   Use this to stop an output if its value hasn't been updated recently.
+     * @param  id: the ID of the servo
+     * @retval (unsigned long) milliseconds since the servo's data was last received, or ULONG_MAX if it never was
+     */
+    unsigned long getAge_xrp_servo(const uint8_t id)
+    {
+        return getAge<xrp_servo_t>(id);
+    }
+    /**
+     * @brief  Retrieves the values of several servos with consecutive IDs in one call.
+     * @note   Servos that haven't been received are set to 0.0.
+     * @param  values: an array to fill, values[i] is the servo with ID firstId + i
+     * @param  count: the number of elements in values
+     * @param  firstId: the ID of the servo that goes in values[0], default 0
+     * @retval (int) how many of the servos have been received
+     */
+    int getValues_xrp_servo(float* values, int count, uint8_t firstId = 0)
+    {
+        return getValues<xrp_servo_t>(values, count, firstId, 0.0f, [](const xrp_servo_t& data) { return data.value; });
+    }
+    /**
+     * @brief  Call a function each time data for a specific servo is received, as soon as its block is parsed (before the receive callback).
+     * @note   After beginTask(), it's called from update() instead, for each servo that was received since the last update().
+     * @param  id: the ID of the servo
+     * @param  handler: the function to call, nullptr to stop calling a function
+     * @param  context: passed to handler, for example a pointer to an object
+     * @retval (bool) false if the ID is too large to be received
+     */
+    bool onReceive_xrp_servo(const uint8_t id, void (*handler)(const xrp_servo_t& data, void* context), void* context = nullptr)
+    {
+        return setHandler<xrp_servo_t>(id, handler, context);
+    }
+    /**
+     * @brief  Write the value of a specific servo into a variable each time it's received, as soon as its block is parsed (before the receive callback).
+     * @note   After beginTask(), it's written by update() instead. Use onReceive_xrp_servo(id, nullptr) to stop writing it.
+     * @param  id: the ID of the servo
+     * @param  value: the variable to write, it must stay valid until the binding is removed
+     * @retval (bool) false if the ID is too large to be received
+     */
+    bool bind_xrp_servo(const uint8_t id, float& value)
+    {
+        return setHandler<xrp_servo_t>(id, [](const xrp_servo_t& data, void* variable) { *(float*)variable = data.value; }, &value);
+    }
     /**
      * @brief  Retrieves data for a specific digital input/output by ID.
      * @param  data: a reference to an xrp_dio_t structure to fill with data
      * @param  id: the ID of the digital input/output
-     * @retval (bool) true if data was found, false otherwise
+     * @retval (bool) true if data has been received for this ID (it may be from an earlier packet, see getAge), false otherwise
      */
     bool getData_xrp_dio(xrp_dio_t& data, const uint8_t id)
     {
@@ -130,11 +346,56 @@ public:
             return data.value == 1;
         return false;
     }
+    /**
+     * @brief  How long ago data for a specific digital input/output was received.
+     * @note   Use this to stop an output if its value hasn't been updated recently.
+     * @param  id: the ID of the digital input/output
+     * @retval (unsigned long) milliseconds since the digital input/output's data was last received, or ULONG_MAX if it never was
+     */
+    unsigned long getAge_xrp_dio(const uint8_t id)
+    {
+        return getAge<xrp_dio_t>(id);
+    }
+    /**
+     * @brief  Retrieves the values of several digital inputs/outputs with consecutive IDs in one call.
+     * @note   Digital inputs/outputs that haven't been received are set to false.
+     * @param  values: an array to fill, values[i] is the digital input/output with ID firstId + i
+     * @param  count: the number of elements in values
+     * @param  firstId: the ID of the digital input/output that goes in values[0], default 0
+     * @retval (int) how many of the digital inputs/outputs have been received
+     */
+    int getValues_xrp_dio(bool* values, int count, uint8_t firstId = 0)
+    {
+        return getValues<xrp_dio_t>(values, count, firstId, false, [](const xrp_dio_t& data) { return data.value == 1; });
+    }
+    /**
+     * @brief  Call a function each time data for a specific digital input/output is received, as soon as its block is parsed (before the receive callback).
+     * @note   After beginTask(), it's called from update() instead, for each digital input/output that was received since the last update().
+     * @param  id: the ID of the digital input/output
+     * @param  handler: the function to call, nullptr to stop calling a function
+     * @param  context: passed to handler, for example a pointer to an object
+     * @retval (bool) false if the ID is too large to be received
+     */
+    bool onReceive_xrp_dio(const uint8_t id, void (*handler)(const xrp_dio_t& data, void* context), void* context = nullptr)
+    {
+        return setHandler<xrp_dio_t>(id, handler, context);
+    }
+    /**
+     * @brief  Write the value of a specific digital input/output into a variable each time it's received, as soon as its block is parsed (before the receive callback).
+     * @note   After beginTask(), it's written by update() instead. Use onReceive_xrp_dio(id, nullptr) to stop writing it.
+     * @param  id: the ID of the digital input/output
+     * @param  value: the variable to write, it must stay valid until the binding is removed
+     * @retval (bool) false if the ID is too large to be received
+     */
+    bool bind_xrp_dio(const uint8_t id, bool& value)
+    {
+        return setHandler<xrp_dio_t>(id, [](const xrp_dio_t& data, void* variable) { *(bool*)variable = data.value == 1; }, &value);
+    }
     /**
      * @brief  Retrieves data for a specific analog input by ID.
      * @param  data: a reference to an xrp_analog_t structure to fill with data
      * @param  id: the ID of the analog input
-     * @retval (bool) true if data was found, false otherwise
+     * @retval (bool) true if data has been received for this ID (it may be from an earlier packet, see getAge), false otherwise
      */
     bool getData_xrp_analog(xrp_analog_t& data, const uint8_t id)
     {
@@ -153,12 +414,57 @@ public:
             return data.value;
         return 0.0f;
     }
+    /**
+     * @brief  How long ago data for a specific analog input was received.
+     * @note   Use this to stop an output if its value hasn't been updated recently.
+     * @param  id: the ID of the analog input
+     * @retval (unsigned long) milliseconds since the analog input's data was last received, or ULONG_MAX if it never was
+     */
+    unsigned long getAge_xrp_analog(const uint8_t id)
+    {
+        return getAge<xrp_analog_t>(id);
+    }
+    /**
+     * @brief  Retrieves the values of several analog inputs with consecutive IDs in one call.
+     * @note   Analog inputs that haven't been received are set to 0.0.
+     * @param  values: an array to fill, values[i] is the analog input with ID firstId + i
+     * @param  count: the number of elements in values
+     * @param  firstId: the ID of the analog input that goes in values[0], default 0
+     * @retval (int) how many of the analog inputs have been received
+     */
+    int getValues_xrp_analog(float* values, int count, uint8_t firstId = 0)
+    {
+        return getValues<xrp_analog_t>(values, count, firstId, 0.0f, [](const xrp_analog_t& data) { return data.value; });
+    }
+    /**
+     * @brief  Call a function each time data for a specific analog input is received, as soon as its block is parsed (before the receive callback).
+     * @note   After beginTask(), it's called from update() instead, for each analog input that was received since the last update().
+     * @param  id: the ID of the analog input
+     * @param  handler: the function to call, nullptr to stop calling a function
+     * @param  context: passed to handler, for example a pointer to an object
+     * @retval (bool) false if the ID is too large to be received
+     */
+    bool onReceive_xrp_analog(const uint8_t id, void (*handler)(const xrp_analog_t& data, void* context), void* context = nullptr)
+    {
+        return setHandler<xrp_analog_t>(id, handler, context);
+    }
+    /**
+     * @brief  Write the value of a specific analog input into a variable each time it's received, as soon as its block is parsed (before the receive callback).
+     * @note   After beginTask(), it's written by update() instead. Use onReceive_xrp_analog(id, nullptr) to stop writing it.
+     * @param  id: the ID of the analog input
+     * @param  value: the variable to write, it must stay valid until the binding is removed
+     * @retval (bool) false if the ID is too large to be received
+     */
+    bool bind_xrp_analog(const uint8_t id, float& value)
+    {
+        return setHandler<xrp_analog_t>(id, [](const xrp_analog_t& data, void* variable) { *(float*)variable = data.value; }, &value);
+    }
 
     // methods to send data (add methods when you add new message types)
     /**
      * @brief  Sends data for a specific digital input by ID.
      * @param  data: the xrp_dio_t structure containing the data to send (including ID)
-     * @param  checkUniqueness: if true, it checks if a message with the same ID already exists in the sent messages, default false
+     * @param  checkUniqueness: unused, kept for compatibility (a block with the same tag and ID as an earlier one always replaces it)
      * @retval (bool) true if data was queued successfully, false otherwise
      */
     bool sendData_xrp_dio(const xrp_dio_t& data, bool checkUniqueness = false)
@@ -169,7 +475,7 @@ public:
      * @brief  Send a boolean value for a specific digital input/output by ID.
      * @param  id: the ID of the digital input/output
      * @param  value: (bool) the boolean value to send (true or false)
-     * @param  checkUniqueness: If true, it checks if a message with the same ID already exists in the sent messages, default false
+     * @param  checkUniqueness: unused, kept for compatibility (a block with the same tag and ID as an earlier one always replaces it)
      * @retval (bool) true if data was queued successfully, false otherwise
      */
     bool sendValue_xrp_dio(const uint8_t id, bool value, bool checkUniqueness = false)
@@ -180,10 +486,22 @@ public:
         return sendData_xrp_dio(data, checkUniqueness);
     }
 
+    /**
+     * @brief  Send the values of several digital inputs/outputs with consecutive IDs in one call.
+     * @param  values: values[i] is sent for the digital input/output with ID firstId + i
+     * @param  count: the number of elements in values
+     * @param  firstId: the ID of values[0], default 0
+     * @retval (int) how many values were queued, less than count if the buffer is full
+     */
+    int sendValues_xrp_dio(const bool* values, int count, uint8_t firstId = 0)
+    {
+        return sendValues<xrp_dio_t>(count, [&](int i) { return xrp_dio_t { (uint8_t)(firstId + i), (uint8_t)(values[i] ? 1 : 0) }; });
+    }
+
     /**
      * @brief  Sends data for a specific analog input by ID.
      * @param  data: the xrp_analog_t structure containing the data to send (including ID)
-     * @param  checkUniqueness: If true, it checks if a message with the same ID already exists in the sent messages, default false
+     * @param  checkUniqueness: unused, kept for compatibility (a block with the same tag and ID as an earlier one always replaces it)
      * @retval (bool) true if data was queued successfully, false otherwise
      */
     bool sendData_xrp_analog(const xrp_analog_t& data, bool checkUniqueness = false)
@@ -195,7 +513,7 @@ public:
      * @brief  Sends a float value for a specific analog input by ID.
      * @param  id: the ID of the analog input
      * @param  value: (float) the value to send
-     * @param  checkUniqueness: If true, it checks if a message with the same ID already exists in the sent messages, default false
+     * @param  checkUniqueness: unused, kept for compatibility (a block with the same tag and ID as an earlier one always replaces it)
      * @retval (bool) true if data was queued successfully, false otherwise
      */
     bool sendValue_xrp_analog(const uint8_t id, float value, bool checkUniqueness = false)
@@ -206,10 +524,22 @@ public:
         return sendData_xrp_analog(data, checkUniqueness);
     }
 
+    /**
+     * @brief  Send the values of several analog inputs with consecutive IDs in one call.
+     * @param  values: values[i] is sent for the analog input with ID firstId + i
+     * @param  count: the number of elements in values
+     * @param  firstId: the ID of values[0], default 0
+     * @retval (int) how many values were queued, less than count if the buffer is full
+     */
+    int sendValues_xrp_analog(const float* values, int count, uint8_t firstId = 0)
+    {
+        return sendValues<xrp_analog_t>(count, [&](int i) { return xrp_analog_t { (uint8_t)(firstId + i), values[i] }; });
+    }
+
     /**
      * @brief  Sends data for a specific encoder by ID
      * @param  data: the xrp_encoder_t structure containing the data to send (including ID)
-     * @param  checkUniqueness: If true, it checks if a message with the same ID already exists in the sent messages, default false
+     * @param  checkUniqueness: unused, kept for compatibility (a block with the same tag and ID as an earlier one always replaces it)
      * @retval (bool) true if data was queued successfully, false otherwise
      */
     bool sendData_xrp_encoder(const xrp_encoder_t& data, bool checkUniqueness = false)
@@ -223,7 +553,7 @@ public:
      * @param  count: (int32_t) count of encoder ticks
      * @param  period: (int32_t) encoder period
      * @param  divisor: (int32_t) encoder divisor
-     * @param  checkUniqueness: If true, it checks if a message with the same ID already exists in the sent messages, default false
+     * @param  checkUniqueness: unused, kept for compatibility (a block with the same tag and ID as an earlier one always replaces it)
      * @retval (bool) true if data was queued successfully, false otherwise
      */
     bool sendValue_xrp_encoder(const uint8_t id, int32_t count, int32_t period = 0, int32_t divisor = 1, bool checkUniqueness = false)
@@ -236,11 +566,34 @@ public:
         return sendData_xrp_encoder(data, checkUniqueness);
     }
 
+    /**
+     * @brief  Send data for several encoders in one call.
+     * @param  data: an array of xrp_encoder_t structures (each including its ID)
+     * @param  count: the number of elements in data
+     * @retval (int) how many encoders were queued, less than count if the buffer is full
+     */
+    int sendDataArray_xrp_encoder(const xrp_encoder_t* data, int count)
+    {
+        return sendValues<xrp_encoder_t>(count, [&](int i) { return data[i]; });
+    }
+
+    /**
+     * @brief  Send the counts of several encoders with consecutive IDs in one call.
+     * @param  counts: counts[i] is sent for the encoder with ID firstId + i, with period 0 and divisor 1
+     * @param  count: the number of elements in counts
+     * @param  firstId: the ID of counts[0], default 0
+     * @retval (int) how many encoders were queued, less than count if the buffer is full
+     */
+    int sendValues_xrp_encoder(const int32_t* counts, int count, uint8_t firstId = 0)
+    {
+        return sendValues<xrp_encoder_t>(count, [&](int i) { return xrp_encoder_t { (uint8_t)(firstId + i), counts[i], 0, 1 }; });
+    }
+
     /**
      * @brief  Sends gyroscope data
      * @note  XRP gyroscope data doesn't have an ID, so only one gyroscope can be transmitted
      * @param  data: the xrp_gyro_t structure containing the gyroscope data
-     * @param  checkUniqueness: If true, it checks if a message with the same ID already exists in the sent messages, default false
+     * @param  checkUniqueness: unused, kept for compatibility (a block with the same tag and ID as an earlier one always replaces it)
      * @retval (bool) true if data was queued successfully, false otherwise
      */
     bool sendData_xrp_gyro(const xrp_gyro_t& data, bool checkUniqueness = false)
@@ -257,7 +610,7 @@ public:
      * @param  roll: (float) angle around X axis
      * @param  pitch: (float) angle around Y axis
      * @param  yaw: (float) angle around Z axis
-     * @param  checkUniqueness: If true, it checks if a message with the same ID already exists in the sent messages, default false
+     * @param  checkUniqueness: unused, kept for compatibility (a block with the same tag and ID as an earlier one always replaces it)
      * @retval (bool) true if data was queued successfully, false otherwise
      */
     bool sendValue_xrp_gyro(float xRate, float yRate, float zRate, float roll, float pitch, float yaw, bool checkUniqueness = false)
@@ -276,7 +629,7 @@ public:
      * @brief  Sends accelerometer data
      * @note  XRP accelerometer data doesn't have an ID, so only one accelerometer can be transmitted
      * @param  data: the xrp_accel_t structure containing the accelerometer data
-     * @param  checkUniqueness: If true, it checks if a message with the same ID already exists in the sent messages, default false
+     * @param  checkUniqueness: unused, kept for compatibility (a block with the same tag and ID as an earlier one always replaces it)
      * @retval (bool) true if data was queued successfully, false otherwise
      */
     bool sendData_xrp_accel(const xrp_accel_t& data, bool checkUniqueness = false)
@@ -290,7 +643,7 @@ public:
      * @param  xAccel: (float) acceleration in X/forward direction
      * @param  yAccel: (float) acceleration in Y/left direction
      * @param  zAccel: (float) acceleration in Z/up direction
-     * @param  checkUniqueness: If true, it checks if a message with the same ID already exists in the sent messages, default false
+     * @param  checkUniqueness: unused, kept for compatibility (a block with the same tag and ID as an earlier one always replaces it)
      * @retval (bool) true if data was queued successfully, false otherwise
      */
     bool sendValue_xrp_accel(const uint8_t id, float xAccel, float yAccel, float zAccel, bool checkUniqueness = false)
@@ -302,10 +655,55 @@ public:
         return sendData_xrp_accel(data, checkUniqueness);
     }
 
+    /**
+     * @brief  Sends data for an encoder like sendData_xrp_encoder, and if sendSampleBatches is set also keeps it with the time it was taken
+     * Call this as often as the encoder is read, every sample since the last packet is then sent, not just the newest.
+     * @param  data: the xrp_encoder_t structure containing the data to send (including ID)
+     * @retval (bool) true if data was queued successfully, false otherwise
+     */
+    bool sampleData_xrp_encoder(const xrp_encoder_t& data)
+    {
+        return sampleData(data, encoderSamples);
+    }
+
+    /**
+     * @brief  Sends values for an encoder like sendValue_xrp_encoder, and if sendSampleBatches is set also keeps them with the time they were taken
+     * @param  id: the ID of the encoder
+     * @param  count: (int32_t) count of encoder ticks
+     * @param  period: (int32_t) encoder period
+     * @param  divisor: (int32_t) encoder divisor
+     * @retval (bool) true if data was queued successfully, false otherwise
+     */
+    bool sampleValue_xrp_encoder(const uint8_t id, int32_t count, int32_t period = 0, int32_t divisor = 1)
+    {
+        return sampleData_xrp_encoder(xrp_encoder_t { id, count, period, divisor });
+    }
+
+    /**
+     * @brief  Sends gyroscope data like sendData_xrp_gyro, and if sendSampleBatches is set also keeps it with the time it was taken
+     * @param  data: the xrp_gyro_t structure containing the gyroscope data
+     * @retval (bool) true if data was queued successfully, false otherwise
+     */
+    bool sampleData_xrp_gyro(const xrp_gyro_t& data)
+    {
+        return sampleData(data, gyroSamples);
+    }
+
+    /**
+     * @brief  set to true to send every sample passed to the sampleData methods since the last packet, not just the newest one
+     * The newest sample is still sent in the normal block that wpilib reads. The others follow in extra blocks with the tag
+     * XSWC_TAG_SAMPLE_BATCH, which wpilib ignores: after the size byte and tag comes the tag of the sampled type, then
+     * samples of 4 bytes of micros() followed by the sampled type's fields, oldest first, as many as fit in one block.
+     * Up to SampleBufferSize samples of each type are kept, older ones are dropped. The global xswc doesn't keep any,
+     * make your own instance to use this, for example BasicXSWC<UDP_PACKET_MAX_SIZE_XRP, 2000, 16, false, 4, 32>.
+     */
+    bool sendSampleBatches = false;
+
     /**
      * @brief constructor of XSWC class, use the global xswc instance to access this class
      */
-    XSWC();
+    BasicXSWC();
+    ~BasicXSWC();
 
     /**
      * @brief  begin udp communication on given port
@@ -331,18 +729,356 @@ public:
      */
     bool begin(const char* ssid, const char* password, void (*_receiveCallback)(void), void (*_sendCallback)(void), const char* hostname = "XRP-XSWC", uint16_t port = 3540);
 
+    /**
+     * @brief  use a different UDP implementation instead of the built in WiFiUDP, call this before begin()
+     * @note   this is mostly for running the library on a computer, for example with a mock UDP class for testing
+     * @param  transport: any class implementing the Arduino UDP interface, it must stay valid while XSWC uses it
+     */
+    void setTransport(UDP& transport)
+    {
+        udp = &transport;
+    }
+
+    /**
+     * @brief  use different functions to get the time, instead of millis() and micros()
+     * @note   this is mostly for running the library on a computer, for example to replay recorded packets with their original timing
+     * @param  millisFunction: returns milliseconds, like millis()
+     * @param  microsFunction: returns microseconds, like micros()
+     */
+    void setClock(unsigned long (*millisFunction)(void), unsigned long (*microsFunction)(void))
+    {
+        clockMillis = millisFunction;
+        clockMicros = microsFunction;
+    }
+
+    /**
+     * @brief  record every packet that's received and sent, for example to replay a match on a computer with extras/replay
+     * @note   the recorder is called by the communication task if beginTask() was used, so don't set it while the task is running
+     * @param  _recorder: a StreamRecorder, a RingRecorder or another PacketRecorder, nullptr to stop recording, it must stay valid while XSWC uses it
+     */
+    void setRecorder(PacketRecorder* _recorder)
+    {
+        recorder = _recorder;
+    }
+
     /**
      * @brief  call this in void loop()
+     * @note   after beginTask(), this only hands data to and from the communication task and runs the callbacks, it never waits for the network
      * @retval true if data was just received
      */
     bool update();
 
+    /**
+     * @brief  receive, parse and send packets in a separate task, so a slow network never delays loop()
+     * Call this after begin(). update() must still be called in loop(), the callbacks keep running there.
+     * Received values and telemetry are passed between the task and loop() through lock-free buffers, so neither one waits for the other.
+     * @note   on an ESP32, Arduino's loop() runs on core 1, so the default of core 0 puts the task on the other core
+     * @param  core: the core to run the task on, -1 for any core
+     * @param  backend: how to create the task, the default uses FreeRTOS on an ESP32 and std::thread on a computer
+     * @retval (bool) true if the task was started, false if there's no backend for this platform, it's already running, or SharedBuffer is set
+     */
+    bool beginTask(int core = 0, TaskBackend* backend = defaultTaskBackend());
+
+    /**
+     * @brief  stop the task started by beginTask() and go back to doing everything in update()
+     */
+    void endTask();
+
+    /**
+     * @brief  whether beginTask() has been called (and not endTask())
+     */
+    bool isTaskRunning()
+    {
+        return task != nullptr;
+    }
+
+    /**
+     * @brief  how much RAM this configuration uses, without the communication task
+     * @note   for example BasicXSWC<8192>::staticRamBytes(). The tables used by onReceive/bind and by deltaTelemetry
+     *         aren't included, they're allocated the first time they're used.
+     * @retval (size_t) bytes, the size of the global xswc object for the default configuration
+     */
+    static constexpr size_t staticRamBytes()
+    {
+        return sizeof(BasicXSWC);
+    }
+
+    /**
+     * @brief  how much RAM beginTask() allocates for passing data to and from the communication task (the task's stack isn't included)
+     * @retval (size_t) bytes
+     */
+    static constexpr size_t taskRamBytes()
+    {
+        return sizeof(TaskState);
+    }
+
+    unsigned long TASK_PERIOD_MS = 1; // how long the communication task sleeps between checks for packets
+
     bool isConnected();
     bool isEnabled();
     bool isConnectedAndEnabled();
 
-    unsigned long TIMEOUT_MS = 1000;
-    unsigned long MIN_UPDATE_TIME_MS = 50; // 20Hz
+    unsigned long TIMEOUT_MS = 1000; // the link is lost if nothing is received for this long, with adaptiveTimeout this is the longest timeout
+
+    /**
+     * @brief  set to true to derive the timeout from how often packets arrive, so a lost link is noticed sooner than TIMEOUT_MS
+     * The timeout is ADAPTIVE_TIMEOUT_FACTOR times the 99th percentile of the time between packets, measured over
+     * every ADAPTIVE_TIMEOUT_WINDOW updates that received packets and kept between MIN_TIMEOUT_MS and TIMEOUT_MS. TIMEOUT_MS is used until
+     * the first window is complete. A gap long enough that ADAPTIVE_TIMEOUT_FACTOR times it is more than the current timeout raises the
+     * timeout right away, so a sender that slows down is followed before it times out. A gap longer than the timeout loses the link
+     * (the timeout callback is called), and the measurement starts over for the next connection.
+     */
+    bool adaptiveTimeout = false;
+    float ADAPTIVE_TIMEOUT_FACTOR = 3;
+    unsigned long MIN_TIMEOUT_MS = 100;
+    unsigned int ADAPTIVE_TIMEOUT_WINDOW = 64;
+
+    /**
+     * @brief  how long the link may be silent before it's lost, TIMEOUT_MS unless adaptiveTimeout is set
+     */
+    unsigned long getTimeoutMs();
+
+    /**
+     * @brief  set a function that update() calls as soon as the link times out, to put the robot in a safe state
+     * Before it's called the received values are forgotten: getData returns false, getValue returns its default and isEnabled() returns false until a new packet arrives.
+     * @param  callback: called once per lost link, nullptr for none
+     */
+    void onTimeout(void (*callback)(void))
+    {
+        timeoutCallback = callback;
+    }
+    unsigned long MIN_UPDATE_TIME_MS = 50; // 20Hz, used by TX_PERIODIC
+
+    /**
+     * @brief  set to true for TX_PERIODIC to send telemetry as often as commands arrive instead of every MIN_UPDATE_TIME_MS
+     * The interval is kept between MIN_TELEMETRY_INTERVAL_MS and MAX_TELEMETRY_INTERVAL_MS. When received packets are lost
+     * or endPacket() fails, the link is assumed to be congested and the interval is doubled, then it returns to the command rate gradually.
+     * MIN_UPDATE_TIME_MS is used while no remote is connected.
+     */
+    bool adaptiveTelemetryRate = false;
+    unsigned long MIN_TELEMETRY_INTERVAL_MS = 5;
+    unsigned long MAX_TELEMETRY_INTERVAL_MS = 200;
+
+    /**
+     * @brief  how often TX_PERIODIC sends telemetry now, MIN_UPDATE_TIME_MS unless adaptiveTelemetryRate is set
+     */
+    unsigned long getTelemetryIntervalMs()
+    {
+        return adaptiveTelemetryRate ? telemetryIntervalMs : MIN_UPDATE_TIME_MS;
+    }
+
+    /**
+     * @brief  when update() sends telemetry
+     */
+    enum TxPolicy {
+        TX_PERIODIC, // every MIN_UPDATE_TIME_MS, independent of when commands arrive
+        TX_REPLY_ON_RECEIVE, // right after a received packet is processed, so telemetry is at most one round trip behind the command
+    };
+    TxPolicy txPolicy = TX_PERIODIC;
+    unsigned long MIN_REPLY_SPACING_MS = 0; // TX_REPLY_ON_RECEIVE doesn't reply to packets that arrive sooner than this after the last send
+    unsigned long HEARTBEAT_MS = 50; // TX_REPLY_ON_RECEIVE still sends if nothing was sent for this long
+    /**
+     * @brief  set to true to only send blocks whose value changed by more than the deadband since it was last sent
+     * wpilib keeps the last value it received for each channel, so unchanged values don't need to be sent again.
+     * Every TELEMETRY_KEYFRAME_INTERVAL sends, and after connecting, every block is sent, in case a packet was lost.
+     * A value only counts as sent once its packet was sent without an error.
+     * The last sent values are kept in a table that's allocated the first time it's needed.
+     */
+    bool deltaTelemetry = false;
+    float TELEMETRY_DEADBAND = 0; // used by channels without their own deadband, 0 sends any change
+    unsigned int TELEMETRY_KEYFRAME_INTERVAL = 20; // with deltaTelemetry, every block is sent once every this many sends
+
+    /**
+     * @brief  set how much one channel has to change before deltaTelemetry sends it again
+     * @param  tag: the type of the channel, for example XRP_TAG_ANALOG
+     * @param  id: the ID of the channel (0 for types without an ID)
+     * @param  deadband: the smallest change of any field that's sent, negative to use TELEMETRY_DEADBAND
+     * @retval (bool) false if the tag isn't a type that can be sent or the id is too large to store a deadband for
+     */
+    bool setTelemetryDeadband(uint8_t tag, uint8_t id, float deadband)
+    {
+        if (tag < XRP_TAG_FIRST || tag >= XRP_TAG_FIRST + XRP_TAG_COUNT || id >= MaxChannelsPerTag) {
+            return false;
+        }
+        return setTelemetryDeadbandOf(xrp_sendable_types(), tag, id, deadband);
+    }
+
+    unsigned int MAX_DATAGRAM_SIZE = UDP_PACKET_MAX_SIZE_XRP; // telemetry larger than this is split into several datagrams, each with its own header and sequence number
+    unsigned int MAX_PACKETS_PER_UPDATE = 16; // queued packets read per update(), they're applied oldest first and the receive callback runs once, so a backlog never delays commands (1 reads one packet per update())
+    unsigned int SEQUENCE_RESYNC_DISTANCE = 1000; // a packet this many sequence numbers older than the newest one is assumed to be from a restarted sender and is accepted
+
+    /**
+     * @brief  also send telemetry to an address that doesn't send commands, for example a dashboard, a logger or a multicast group
+     * Each packet is serialized once and sent to the remote that sends commands (if one is connected) and to every subscriber.
+     * Subscribers get telemetry even while no remote is connected. Packets they send are ignored like those from any other second device.
+     * @note   don't call this while the task started by beginTask() is running
+     * @param  address: the subscriber's IP address, or a multicast group like 239.0.0.1
+     * @param  port: the UDP port the subscriber listens on
+     * @retval (bool) false if MaxSubscribers subscribers were already added, the address was already added, or the task is running
+     */
+    bool addTelemetrySubscriber(IPAddress address, uint16_t port)
+    {
+        if (task != nullptr || subscriberCount >= MaxSubscribers || findTelemetrySubscriber(address, port) >= 0) {
+            return false;
+        }
+        subscribers[subscriberCount].address = address;
+        subscribers[subscriberCount].port = port;
+        subscriberCount++;
+        txSendsSinceKeyframe = TELEMETRY_KEYFRAME_INTERVAL; // with deltaTelemetry, send every block to the new subscriber next time
+        return true;
+    }
+
+    /**
+     * @brief  stop sending telemetry to an address added with addTelemetrySubscriber()
+     * @note   don't call this while the task started by beginTask() is running
+     * @retval (bool) false if the address wasn't a subscriber or the task is running
+     */
+    bool removeTelemetrySubscriber(IPAddress address, uint16_t port)
+    {
+        int index = findTelemetrySubscriber(address, port);
+        if (task != nullptr || index < 0) {
+            return false;
+        }
+        subscribers[index] = subscribers[subscriberCount - 1];
+        subscriberCount--;
+        return true;
+    }
+
+    /**
+     * @brief  how many addresses were added with addTelemetrySubscriber()
+     */
+    int getTelemetrySubscriberCount()
+    {
+        return subscriberCount;
+    }
+
+    /**
+     * @brief  cumulative counters about the communication link
+     */
+    struct Stats {
+        uint32_t packetsReceived = 0; // datagrams read from the remote, including ones that are then ignored
+        uint32_t bytesReceived = 0;
+        uint32_t packetsSent = 0; // datagrams sent, to the remote and to each telemetry subscriber
+        uint32_t bytesSent = 0;
+        uint32_t packetsFromOtherRemotes = 0; // packets ignored because another remote is connected
+        uint32_t parseShortPackets = 0; // packets too short for the header
+        uint32_t parseBadSize = 0; // packets with a block whose size byte is wrong, the rest of the packet is ignored
+        uint32_t parseUnknownTags = 0; // blocks skipped because their tag isn't one that can be received
+        uint32_t parseIdOutOfRange = 0; // blocks skipped because their id isn't below MaxChannelsPerTag
+        uint32_t packetsLost = 0; // sequence numbers that were skipped (a packet that arrives late is subtracted again)
+        uint32_t packetsDuplicated = 0; // packets with a sequence number that was already applied, they are ignored
+        uint32_t packetsReordered = 0; // packets that arrived after a newer packet, they are ignored
+        uint32_t packetsCoalesced = 0; // packets followed by a newer packet read in the same update(), only channels the newer packet doesn't have keep their values
+        uint32_t telemetryBlocksSkipped = 0; // blocks deltaTelemetry didn't send because they hadn't changed
+        uint32_t telemetryBytesSaved = 0; // bytes of those blocks
+        uint32_t telemetryFramesSplit = 0; // sends that didn't fit in one datagram of MAX_DATAGRAM_SIZE bytes
+        uint32_t telemetryExtraDatagrams = 0; // datagrams sent beyond the first one for those sends
+        uint32_t telemetryBlocksDropped = 0; // blocks that didn't fit in MAX_DATAGRAMS_PER_FRAME datagrams
+        uint32_t telemetryBufferFull = 0; // blocks the sendData methods couldn't queue because the buffer was full (TxSize)
+        uint32_t telemetrySendFailures = 0; // datagrams to the remote that endPacket() couldn't send
+        uint32_t subscriberSendFailures = 0; // datagrams to telemetry subscribers that endPacket() couldn't send
+        uint32_t telemetrySamplesSent = 0; // samples sent in XSWC_TAG_SAMPLE_BATCH blocks
+        uint32_t telemetrySamplesDropped = 0; // samples that didn't fit in the sample buffer or the packet
+        uint32_t linkTimeouts = 0; // times the link was lost because nothing was received for getTimeoutMs()
+    };
+
+    /**
+     * @brief  set to true to send some of the counters as telemetry, so they can be charted on the computer without any code on the robot
+     * analog STATS_ANALOG_FIRST_ID: packetsReceived, +1: packetsLost, +2: parse errors (short packets, bad sizes, unknown tags and ids out of range),
+     * +3: telemetry that couldn't be sent (blocks dropped, buffer full and endPacket() failures),
+     * dio STATS_DIO_ID: false in the first packet after any of those counts went up, true otherwise.
+     * The counts wrap around to 0 after 16777215 (2^24 - 1), the largest whole numbers a float holds exactly.
+     * Choose IDs the robot doesn't use for anything else, these blocks replace the ones sendCallback wrote with the same IDs.
+     */
+    bool reportStats = false;
+    uint8_t STATS_ANALOG_FIRST_ID = 12;
+    uint8_t STATS_DIO_ID = 15;
+
+    /**
+     * @brief  get the counters about the communication link
+     * @note   after beginTask(), the counters are copied from the task each time a packet is received
+     * @retval (Stats) a copy of the counters
+     */
+    Stats getStats()
+    {
+        Stats result = (task != nullptr) ? task->commands.readBuffer().stats : stats;
+        // these are counted by update() even when the task is running
+        result.telemetryBlocksSkipped = txBlocksSkipped;
+        result.telemetryBytesSaved = txBytesSaved;
+        result.linkTimeouts = linkTimeouts;
+        result.telemetrySamplesSent = txSamplesSent;
+        result.telemetrySamplesDropped = txSamplesDropped;
+        result.telemetryBufferFull = txBufferFull;
+        return result;
+    }
+
+    /**
+     * @brief  set all counters returned by getStats() to zero
+     * @note   don't call this while the task started by beginTask() is running
+     */
+    void resetStats()
+    {
+        stats = Stats();
+        txBlocksSkipped = 0;
+        txBytesSaved = 0;
+        linkTimeouts = 0;
+        txSamplesSent = 0;
+        txSamplesDropped = 0;
+        txBufferFull = 0;
+        txProblemsReported = 0;
+        txLostSeen = 0; // else adaptiveTelemetryRate wouldn't see new loss until it passed the old counts
+        txFailuresSeen = 0;
+        for (LatencyHistogram& histogram : latency) {
+            histogram.reset();
+        }
+    }
+
+    /**
+     * @brief  parts of update() that are timed when MeasureLatency is true
+     * @note   while the task started by beginTask() is running, only the callbacks are timed
+     */
+    enum LatencyStage {
+        LATENCY_RECEIVE_TO_CALLBACK, // from parsePacket() finding a packet until receiveCallback() is called (reading and parsing)
+        LATENCY_RECEIVE_CALLBACK, // running receiveCallback()
+        LATENCY_SEND_CALLBACK, // running sendCallback() (the sendData methods encode blocks as they're called, so this includes most of the serialization)
+        LATENCY_SERIALIZE, // finishing the packet to send
+        LATENCY_END_PACKET, // beginPacket(), write() and endPacket()
+        NUM_LATENCY_STAGES
+    };
+
+    /**
+     * @brief  summary of the time one stage took, in microseconds
+     */
+    struct LatencyStats {
+        uint32_t count;
+        uint32_t min;
+        uint32_t max;
+        uint32_t p50;
+        uint32_t p99;
+    };
+
+    /**
+     * @brief  get a summary of how long a part of update() has taken since the last resetStats()
+     * @param  stage: which part of update()
+     * @retval (LatencyStats) count, min, max, median and 99th percentile in microseconds
+     */
+    template <bool Enabled = MeasureLatency>
+    LatencyStats getLatencyStats(LatencyStage stage)
+    {
+        static_assert(Enabled, "set the MeasureLatency template parameter of BasicXSWC to true to measure latency");
+        const LatencyHistogram& histogram = latency[stage];
+        return { histogram.getCount(), histogram.getMin(), histogram.getMax(), histogram.percentile(0.5f), histogram.percentile(0.99f) };
+    }
+
+    /**
+     * @brief  get the full histogram of how long a part of update() has taken
+     */
+    template <bool Enabled = MeasureLatency>
+    const LatencyHistogram& getLatencyHistogram(LatencyStage stage)
+    {
+        static_assert(Enabled, "set the MeasureLatency template parameter of BasicXSWC to true to measure latency");
+        return latency[stage];
+    }
 
     /**
      * @brief  set to true before calling begin() to skip straight to creating an Access Point
@@ -350,80 +1086,486 @@ public:
     bool useAP = false;
 
 protected:
-    // recall data from list of received messages
+    // recall data from the table of received channels
     template <typename T>
     bool getData(T& data, const uint8_t id)
     {
-        for (MessageType* msg : receivedMessages) {
-            if (msg->getTag() == TYPE_TO_TAG_VAL(T) && (msg->hasId() == false || msg->getId() == id)) {
-                // Check if we've found a message of the correct type and with the correct ID
-                data = *static_cast<T*>(msg->getData());
-                return true; // Data found
+        ChannelState<T>* state = userChannels().template find<T>(id);
+        if (state == nullptr || state->received == false) {
+            return false; // No data found
+        }
+        state->materialize(); // blocks are only decoded when they're asked for
+        data = state->data;
+        return true; // Data found
+    }
+
+    // fill values[i] with the value of channel firstId + i, channels are stored consecutively so there's no lookup per channel
+    template <typename T, typename V, typename F>
+    int getValues(V* values, int count, uint8_t firstId, V missing, F valueOf)
+    {
+        ChannelState<T>* states = userChannels().template find<T>(firstId); // nullptr if firstId is too large to be stored
+        int stored = (states == nullptr) ? 0 : userChannels().template size<T>() - firstId;
+        int found = 0;
+        for (int i = 0; i < count; i++) {
+            if (i < stored && states[i].received) {
+                states[i].materialize();
+                values[i] = valueOf(states[i].data);
+                found++;
+            } else {
+                values[i] = missing;
+            }
+        }
+        return found;
+    }
+
+    // register a function for one channel, it's called while parsing, or by update() if the communication task is running
+    template <typename T>
+    bool setHandler(const uint8_t id, void (*handler)(const T& data, void* context), void* context)
+    {
+        if (id >= rxChannels.template size<T>()) {
+            return false;
+        }
+        if (rxHandlers == nullptr) {
+            if (handler == nullptr) {
+                return true; // nothing to remove
+            }
+            rxHandlers = new HandlerTable();
+        }
+        ChannelHandler<T>* entry = rxHandlers->template find<T>(id);
+        entry->handler = handler;
+        entry->context = context;
+        entry->updates = userChannels().template find<T>(id)->updates; // only call it for data received from now on
+        return true;
+    }
+
+    // call the handlers of channels that changed in the newest snapshot from the communication task
+    template <typename... Ts>
+    void dispatchHandlers(ChannelTable<type_list<Ts...>>& channels)
+    {
+        if (rxHandlers != nullptr) {
+            (dispatchHandlersOfType<Ts>(channels), ...);
+        }
+    }
+
+    template <typename T, typename Table>
+    void dispatchHandlersOfType(Table& channels)
+    {
+        for (int id = 0; id < channels.template size<T>(); id++) {
+            ChannelHandler<T>* entry = rxHandlers->template find<T>(id);
+            ChannelState<T>* state = channels.template find<T>(id);
+            if (entry->handler != nullptr && entry->updates != state->updates) {
+                entry->updates = state->updates;
+                entry->handler(state->data, entry->context);
+            }
+        }
+    }
+
+    // milliseconds since a channel was last received
+    template <typename T>
+    unsigned long getAge(const uint8_t id)
+    {
+        ChannelState<T>* state = userChannels().template find<T>(id);
+        if (state == nullptr || state->received == false) {
+            return ULONG_MAX;
+        }
+        return clockMillis() - state->millisWhenReceived;
+    }
+
+    // check one block (buffer[index] is its tag) and record where it is in the table of received channels
+    // the block is decoded later by getData, if the application asks for it
+    template <typename T>
+    int decodeBlockIntoChannel(char* buffer, int index, int length, uint16_t sequence)
+    {
+        if ((uint8_t)buffer[index - 1] != codec<T>::blockSize - 1 || length - index < codec<T>::blockSize - 1) {
+            return 0; // wrong size byte, or the packet is too short
+        }
+        uint8_t id = 0;
+        if constexpr (HAS_ID(T)) {
+            id = (uint8_t)buffer[index + 1 + tag_type<T>::fields::template offsetOf<&T::id>()];
+        }
+        ChannelState<T>* state = rxChannels.template find<T>(id);
+        if (state == nullptr) {
+            stats.parseIdOutOfRange++; // the id is too large to store, the block is ignored
+        } else {
+            state->raw = buffer + index;
+            if constexpr (SharedBuffer) {
+                state->materialize(); // telemetry is queued in the same buffer, so the packet doesn't stay readable
+            }
+            state->millisWhenReceived = millisWhenPacketParsed;
+            state->sequence = sequence;
+            state->updates++;
+            state->received = true;
+            if (task == nullptr && rxHandlers != nullptr) { // else update() calls the handlers, so they never run in the communication task
+                ChannelHandler<T>* entry = rxHandlers->template find<T>(id);
+                if (entry->handler != nullptr) {
+                    state->materialize();
+                    entry->updates = state->updates;
+                    entry->handler(state->data, entry->context);
+                }
+            }
+        }
+        return codec<T>::blockSize - 1;
+    }
+
+    // find the deadband of a channel of the type with the given tag
+    template <typename... Ts>
+    bool setTelemetryDeadbandOf(type_list<Ts...>, uint8_t tag, uint8_t id, float deadband)
+    {
+        return ((tag == TYPE_TO_TAG_VAL(Ts) && setTelemetryDeadbandOf<Ts>(id, deadband)) || ...);
+    }
+
+    template <typename T>
+    bool setTelemetryDeadbandOf(uint8_t id, float deadband)
+    {
+        if (id >= SentTable::template size<T>()) {
+            return false;
+        }
+        sentChannels()->template find<T>(id)->deadband = deadband;
+        return true;
+    }
+
+    // the table of sent values, allocated the first time deltaTelemetry or a deadband needs it
+    ChannelTable<xrp_sendable_types, SentState>* sentChannels()
+    {
+        if (txChannels == nullptr) {
+            txChannels = new SentTable();
+        }
+        return txChannels;
+    }
+
+    // encode data straight into txBuf, replacing an earlier block with the same tag and id
+    template <typename T>
+    bool sendData(const T& data, bool /* checkUniqueness, unused */)
+    {
+        constexpr int tagIndex = TYPE_TO_TAG_VAL(T) - XRP_TAG_FIRST;
+        uint8_t id = 0;
+        if constexpr (HAS_ID(T)) {
+            id = data.id;
+        }
+        int16_t* offset = nullptr; // stays nullptr if the id is too large to store, then the block is just appended
+        SentState<T>* lastSent = nullptr;
+        if (id < SentTable::template size<T>()) {
+            offset = &txBlockOffsets[tagIndex][id];
+            if (deltaTelemetry || txChannels != nullptr) {
+                lastSent = sentChannels()->template find<T>(id);
+            }
+        }
+        int queued = (offset != nullptr) ? *offset : findQueuedBlock<T>(id);
+        if (queued >= 0) {
+            // a block for this tag and id is already in the buffer, overwrite it (blocks of one type are always the same size)
+            codec<T>::encode(data, txBuffer(), queued, TxSize);
+            return true;
+        }
+        if (deltaTelemetry && !txKeyframe && lastSent != nullptr && lastSent->sent) {
+            float deadband = lastSent->deadband < 0 ? TELEMETRY_DEADBAND : lastSent->deadband;
+            if (tag_type<T>::fields::maxDifference(data, lastSent->data) <= deadband) {
+                txBlocksSkipped++;
+                txBytesSaved += codec<T>::blockSize;
+                return true; // wpilib still has a close enough value
             }
         }
-        return false; // No data found
+        int written = codec<T>::encode(data, txBuffer(), txLength, TxSize);
+        if (written == 0) {
+            txBufferFull++;
+            return false; // buffer is full (TxSize)
+        }
+        if (offset != nullptr) {
+            *offset = txLength;
+        }
+        txLength += written;
+        return true;
     }
 
-    // save data into list of messages to send
+    // where an earlier block for this tag and id is in txBuf, -1 if there isn't one
+    // only used for ids too large for txBlockOffsets, it looks at every block
     template <typename T>
-    bool sendData(T data, bool checkUniqueness)
-    {
-        MessageType* message = nullptr;
-        if (checkUniqueness) {
-            // search sent messages for a message with tag and id
-            for (MessageType* msg : sentMessages) {
-                if (msg->getTag() == TYPE_TO_TAG_VAL(T)) {
-                    if constexpr (HAS_ID(T) == false) {
-                        // Found a message of the correct type (and no ID is needed for this type)
-                        message = msg; // overwrite it
-                        break;
-                    } else {
-                        if (msg->getId() == data.id) {
-                            // Found a message of the correct type and with the correct ID
-                            message = msg; // overwrite it
-                            break;
-                        }
-                    }
+    int findQueuedBlock(uint8_t id)
+    {
+        char* buffer = txBuffer();
+        for (int index = 3; index + 1 < txLength; index += (uint8_t)buffer[index] + 1) {
+            if ((uint8_t)buffer[index + 1] != TYPE_TO_TAG_VAL(T)) {
+                continue;
+            }
+            if constexpr (HAS_ID(T)) {
+                if ((uint8_t)buffer[index + 2 + tag_type<T>::fields::template offsetOf<&T::id>()] != id) {
+                    continue;
                 }
             }
+            return index;
         }
-        if (message == nullptr) {
-            // No existing message found, create a new one
-            message = MessageTypeFactory::createMessageType(TYPE_TO_TAG_VAL(T));
+        return -1;
+    }
+
+    // remember the values in the blocks of a packet that was sent, for deltaTelemetry
+    // they're read back from the packet instead of being kept by sendData, so a packet that isn't sent doesn't count
+    template <typename... Ts>
+    void commitSentValues(type_list<Ts...>, char* buffer)
+    {
+        if (txChannels != nullptr) {
+            (commitSentValuesOfType<Ts>(buffer), ...);
         }
-        if (message != nullptr) {
-            message->setData(&data);
-            sentMessages.push_back(message);
-            return true; // Data successfully added to the list
+    }
+
+    template <typename T>
+    void commitSentValuesOfType(char* buffer)
+    {
+        constexpr int tagIndex = TYPE_TO_TAG_VAL(T) - XRP_TAG_FIRST;
+        for (int id = 0; id < SentTable::template size<T>(); id++) {
+            int offset = txBlockOffsets[tagIndex][id];
+            if (offset >= 0) {
+                SentState<T>* lastSent = txChannels->template find<T>(id);
+                tag_type<T>::fields::decode(lastSent->data, buffer, offset + 2); // after the size byte and tag
+                lastSent->sent = true;
+            }
         }
-        return false;
     }
 
-    boolean
-    processReceivedBufferIntoMessages(char* buffer, int length);
-    int processMessagesIntoBufferToSend(char* buffer, int length);
+    // queue makeData(i) for i from 0 to count - 1, stopping when the buffer is full
+    template <typename T, typename F>
+    int sendValues(int count, F makeData)
+    {
+        for (int i = 0; i < count; i++) {
+            if (!sendData<T>(makeData(i), false)) {
+                return i;
+            }
+        }
+        return count;
+    }
 
-    WiFiUDP udp; // UDP instance for communication
+    // send the newest value like sendData, and keep it for the next XSWC_TAG_SAMPLE_BATCH block
+    template <typename T>
+    bool sampleData(const T& data, SampleRing<T, SampleBufferSize>& samples)
+    {
+        if constexpr (SampleBufferSize > 0) {
+            if (sendSampleBatches && !samples.push(clockMicros(), data)) {
+                txSamplesDropped++; // the buffer was full, the oldest sample was replaced
+            }
+        }
+        return sendData<T>(data, false);
+    }
 
-    std::vector<MessageType*> receivedMessages;
-    std::vector<MessageType*> sentMessages;
+    // write the kept samples into txBuf after the other blocks, in as many blocks as needed
+    template <typename T>
+    void appendSampleBatches(SampleRing<T, SampleBufferSize>& samples)
+    {
+        if constexpr (SampleBufferSize > 0) {
+            using fields = typename tag_type<T>::fields;
+            constexpr int sampleSize = 4 + fields::size;
+            constexpr int samplesPerBlock = (255 - 2) / sampleSize; // the size byte counts the tag, the sampled tag and the samples
+            for (int sent = 0; sent < samples.size();) {
+                int inBlock = samples.size() - sent < samplesPerBlock ? samples.size() - sent : samplesPerBlock;
+                int blockSize = 3 + inBlock * sampleSize;
+                if (txLength + blockSize > TxSize) {
+                    txSamplesDropped += samples.size() - sent; // buffer is full (TxSize)
+                    break;
+                }
+                char* buffer = txBuffer();
+                buffer[txLength] = blockSize - 1;
+                buffer[txLength + 1] = XSWC_TAG_SAMPLE_BATCH;
+                buffer[txLength + 2] = TYPE_TO_TAG_VAL(T);
+                int pos = txLength + 3;
+                for (int i = sent; i < sent + inBlock; i++) {
+                    uint32ToNetwork(samples.at(i).micros, buffer, pos);
+                    fields::encode(samples.at(i).data, buffer, pos + 4);
+                    pos += sampleSize;
+                }
+                txLength += blockSize;
+                sent += inBlock;
+                txSamplesSent += inBlock;
+            }
+            samples.clear();
+        }
+    }
+
+    // forget all blocks written into txBuf
+    void clearBufferToSend();
+
+    // what happened to a received packet
+    enum class ParseResult : uint8_t {
+        OK,
+        STALE, // not newer than a packet that was already applied, nothing was changed
+        SHORT_PACKET, // too short to contain the header
+        BAD_SIZE, // a block's size byte doesn't match its content
+        UNKNOWN_TAG, // a block has a tag that can't be received, it was skipped
+    };
+
+    // what the communication task hands to update(), copied after each received packet
+    struct CommandSnapshot {
+        ChannelTable<xrp_receivable_types> channels;
+        boolean cmdEnable;
+        unsigned long millisWhenLastMessageReceived;
+        unsigned long adaptiveTimeoutMs;
+        unsigned long commandIntervalMicros;
+        Stats stats;
+    };
+
+    // what update() hands to the communication task to send
+    struct TelemetryFrame {
+        int length;
+        char data[TxSize];
+    };
+
+    // only exists while the communication task is running
+    struct TaskState {
+        TripleBuffer<CommandSnapshot> commands; // written by the task, read by update()
+        TripleBuffer<TelemetryFrame> telemetry; // written by update(), read by the task
+        TaskBackend* backend;
+        std::atomic<bool> running;
+        std::atomic<bool> telemetryUndelivered; // set by the task when a frame couldn't be sent to every destination
+    };
+
+    // the received channels that getData reads, the task's copy if it's running
+    ChannelTable<xrp_receivable_types>& userChannels()
+    {
+        if (task != nullptr) {
+            return task->commands.readBuffer().channels;
+        }
+        return rxChannels;
+    }
+
+    ParseResult processReceivedBufferIntoMessages(char* buffer, int length);
+    ParseResult decodePacket(char* buffer, int length);
+    bool trackSequence(uint16_t sequence);
+    int processMessagesIntoBufferToSend();
+    bool receivePacket();
+    unsigned long linkTimeoutMs();
+    void recordArrival();
+    void checkLinkTimeout();
+    void adaptTelemetryInterval();
+    void sendStatsTelemetry();
+    bool isTimeToSend(bool gotPacket);
+    int collectTelemetry();
+    void sendTelemetry();
+    bool transmit(char* buffer, int length);
+    int packBlocks(const char* buffer, int length, int limit, int datagram, bool countDropped, int& written);
+    static constexpr int MAX_DATAGRAMS_PER_FRAME = 16;
+    bool updateWithTask();
+    void publishCommands();
+    void taskLoop();
+    static void taskEntry(void* self);
+
+    WiFiUDP wifiUdp; // UDP instance for communication, unless setTransport() is used
+    UDP* udp = &wifiUdp;
+    PacketRecorder* recorder = nullptr;
+
+    unsigned long (*clockMillis)(void) = millis;
+    unsigned long (*clockMicros)(void) = micros;
+
+    ChannelTable<xrp_receivable_types> rxChannels;
+    using HandlerTable = ChannelTable<xrp_receivable_types, ChannelHandler>;
+    HandlerTable* rxHandlers = nullptr; // registered with onReceive and bind, allocated by the first one, only used by the thread that calls update()
 
     boolean cmdEnable = false;
 
     unsigned long millisWhenLastMessageReceived = -TIMEOUT_MS;
+    LatencyHistogram rxInterArrival; // microseconds between packets from the remote, for adaptiveTimeout
+    unsigned long microsWhenLastArrival = 0;
+    bool rxArrivalValid = false; // false until the first packet, so there's no gap to measure
+    unsigned long adaptiveTimeoutMs = ULONG_MAX; // measured timeout, before limiting it to TIMEOUT_MS
+    unsigned long commandIntervalMicros = 0; // average time between packets from the remote, 0 until measured
+    unsigned long telemetryIntervalMs = MIN_UPDATE_TIME_MS; // for adaptiveTelemetryRate
+    uint32_t txLostSeen = 0; // Stats::packetsLost and telemetrySendFailures the last time telemetryIntervalMs was adapted
+    uint32_t txFailuresSeen = 0;
+    bool linkUp = false; // whether update() last saw the link connected, to notice when it times out
+    uint32_t linkTimeouts = 0; // counted by update(), so not in stats
+    void (*timeoutCallback)(void) = nullptr;
     unsigned long millisWhenLastSent = -MIN_UPDATE_TIME_MS;
 
-    uint16_t txSeq = 0;
+    uint16_t txSeq = 0; // keeps counting when the remote changes, so subscribers never see it go backwards
+
+    bool rxSequenceValid = false; // false until a packet has been accepted from the current remote
+    uint16_t lastRxSequence = 0; // newest sequence number that was applied
+    uint32_t rxSequenceWindow = 0; // bit n is set if the packet lastRxSequence - n was received
 
-    char rxBuf[UDP_PACKET_MAX_SIZE_XRP + 1];
-    char txBuf[UDP_PACKET_MAX_SIZE_XRP + 1];
+    Stats stats;
+    std::array<LatencyHistogram, MeasureLatency ? NUM_LATENCY_STAGES : 0> latency; // empty unless MeasureLatency is true
+
+    unsigned long millisWhenPacketParsed = 0; // read once per packet instead of once per block
+    unsigned long microsWhenPacketFound = 0;
+
+    // the time a stage starts, 0 without MeasureLatency so the clock isn't read
+    unsigned long timingStart()
+    {
+        if constexpr (MeasureLatency) {
+            return clockMicros();
+        }
+        return 0;
+    }
+
+    void timingRecord(LatencyStage stage, unsigned long start)
+    {
+        if constexpr (MeasureLatency) {
+            latency[stage].record(clockMicros() - start);
+        }
+    }
+
+    char* indexedBuffer = nullptr; // rxBuf if channels in rxChannels point into it
+
+    TaskState* task = nullptr; // allocated by beginTask()
+
+    // the buffer telemetry is queued in, rxBuf if SharedBuffer is true
+    char* txBuffer()
+    {
+        if constexpr (SharedBuffer) {
+            return rxBuf;
+        } else {
+            return txBuf;
+        }
+    }
+
+    char rxBuf[(SharedBuffer && TxSize > RxSize + 1) ? TxSize : RxSize + 1];
+    char txBuf[SharedBuffer ? 1 : TxSize]; // use txBuffer() instead
+    int txLength; // end of the blocks written into txBuf by sendData
+    int16_t txBlockOffsets[XRP_TAG_COUNT][MaxChannelsPerTag]; // where the block for each tag and id is in txBuf, -1 if not written yet
+    static_assert(TxSize <= INT16_MAX, "TxSize must fit in the int16_t offsets of txBlockOffsets");
+
+    using SentTable = ChannelTable<xrp_sendable_types, SentState>;
+    SentTable* txChannels = nullptr; // the last value written into txBuf for each channel, for deltaTelemetry, use sentChannels()
+    bool txKeyframe = true; // send every block this time, even if deltaTelemetry is on
+    bool txResendAll = false; // a frame handed to the communication task wasn't sent, so the next one is a keyframe
+    bool txWasConnected = false; // isConnected() the last time telemetry was collected, to send a keyframe after connecting
+    unsigned int txSendsSinceKeyframe = 0;
+    uint32_t txBlocksSkipped = 0; // counted here instead of in stats, since stats belongs to the communication task when it's running
+    uint32_t txBytesSaved = 0;
+
+    SampleRing<xrp_encoder_t, SampleBufferSize> encoderSamples; // kept by sampleData for sendSampleBatches, only used by the thread that calls update()
+    SampleRing<xrp_gyro_t, SampleBufferSize> gyroSamples;
+    uint32_t txSamplesSent = 0; // counted here instead of in stats, like txBlocksSkipped
+    uint32_t txSamplesDropped = 0;
+    uint32_t txBufferFull = 0;
+    uint32_t txProblemsReported = 0; // lost, parse error and dropped telemetry counts the last time reportStats sent them
 
     bool connectedToRemote = false;
     IPAddress udpRemoteAddr = IPAddress();
     int32_t udpRemotePort = -1;
 
+    struct TelemetrySubscriber {
+        IPAddress address;
+        uint16_t port;
+    };
+    std::array<TelemetrySubscriber, MaxSubscribers> subscribers;
+    int subscriberCount = 0;
+
+    int findTelemetrySubscriber(IPAddress address, uint16_t port)
+    {
+        for (int i = 0; i < subscriberCount; i++) {
+            if (subscribers[i].address == address && subscribers[i].port == port) {
+                return i;
+            }
+        }
+        return -1;
+    }
+
     void (*sendCallback)(void);
     void (*receiveCallback)(void);
-}; // end class XSWC
+}; // end class BasicXSWC
+
+#include "xrp-style-wpilib-comms-impl.h"
+
+/**
+ * @brief  BasicXSWC with the default capacities (UDP_PACKET_MAX_SIZE_XRP, XSWC_TX_BUFFER_SIZE and XSWC_MAX_CHANNELS_PER_TAG)
+ */
+using XSWC = BasicXSWC<>;
+extern template class BasicXSWC<>; // compiled once, in the .cpp file
 
 extern XSWC xswc; // a global instance is created in the .cpp file
@@ -0,0 +1,145 @@
+/*
+ * update() must not allocate memory once the library is running: on the robot a heap allocation can take long
+ * or fail after the heap is fragmented. Everything that allocates (handler and delta tables) is set up first,
+ * then every heap allocation made inside update() is counted while commands arrive, telemetry is sent and the link times out.
+ */
+
+#include "../xswc_test.h"
+
+#include <cstdlib>
+#include <new>
+
+// count heap allocations, like extras/bench does
+static unsigned long allocationCount = 0;
+
+void* operator new(size_t size)
+{
+    allocationCount++;
+    void* ptr = malloc(size ? size : 1);
+    if (ptr == nullptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+void operator delete(void* ptr) noexcept
+{
+    free(ptr);
+}
+void operator delete(void* ptr, size_t) noexcept
+{
+    free(ptr);
+}
+
+static XSWC* comms = nullptr;
+static BasicXSWC<1000, 4000, 16, false, 4, 32>* sampling = nullptr;
+static float motors[4];
+static float handlerValue = 0;
+static int receives = 0;
+
+void onMotor(const xrp_motor_t& data, void* context)
+{
+    handlerValue = data.value;
+}
+
+template <typename Comms>
+void readCommands(Comms& robot)
+{
+    receives++;
+    robot.getValues_xrp_motor(motors, 4);
+    xrp_motor_t motor;
+    robot.getData_xrp_motor(motor, 1);
+}
+
+template <typename Comms>
+void writeTelemetry(Comms& robot, int encoders)
+{
+    for (int i = 0; i < encoders; i++) {
+        robot.sendValue_xrp_encoder(i, receives + i);
+    }
+    robot.sendValue_xrp_analog(0, motors[0]);
+    robot.sendValue_xrp_analog(1, 7.4f); // doesn't change, so deltaTelemetry skips it
+    robot.sendValue_xrp_dio(0, receives % 2 == 0);
+    robot.sendValue_xrp_gyro(1, 2, 3, 4, 5, receives);
+}
+
+// commands arrive every 10 ms, then stop for longer than the timeout and start again
+template <typename Comms>
+unsigned long countAllocationsInUpdate(Comms& robot, MockUDP& udp)
+{
+    static RingRecorder<4096> recorder;
+    robot.deltaTelemetry = true;
+    robot.reportStats = true;
+    robot.adaptiveTimeout = true;
+    robot.adaptiveTelemetryRate = true;
+    robot.setRecorder(&recorder);
+    robot.addTelemetrySubscriber(IPAddress(127, 0, 0, 9), 3540);
+    robot.onReceive_xrp_motor(0, onMotor);
+    robot.setTelemetryDeadband(XRP_TAG_ANALOG, 0, 0.01f);
+    robot.sendSampleBatches = true;
+
+    unsigned long allocations = 0;
+    uint16_t sequence = 0;
+    for (int i = 0; i < 400; i++) {
+        if (i < 150 || i >= 300) { // nothing arrives in between, so the link times out
+            injectPacket(udp, commandPacket(sequence++, true, { { 0, i / 400.0f }, { 1, 0.5f }, { 2, -0.5f }, { 3, 0 } }));
+            if (i % 50 == 0) {
+                injectPacket(udp, commandPacket(0, true), IPAddress(127, 0, 0, 2)); // another computer, ignored but recorded
+            }
+        }
+        advanceMillis(10);
+        unsigned long before = allocationCount;
+        robot.update();
+        if (i >= 10) { // MockUDP grows its own buffers during the first sends
+            allocations += allocationCount - before;
+        }
+    }
+    TEST_ASSERT_EQUAL(1, robot.getStats().linkTimeouts);
+    TEST_ASSERT_GREATER_THAN(0, robot.getStats().packetsSent);
+    TEST_ASSERT_EQUAL_FLOAT(399 / 400.0f, handlerValue);
+    return allocations;
+}
+
+void test_update_does_not_allocate()
+{
+    MockUDP udp;
+    udp.keepSent = false;
+    beginTest(*comms, udp, [] { readCommands(*comms); }, [] { writeTelemetry(*comms, 8); });
+    TEST_ASSERT_EQUAL(0, countAllocationsInUpdate(*comms, udp));
+}
+
+void test_update_with_split_and_samples_does_not_allocate()
+{
+    MockUDP udp;
+    udp.keepSent = false;
+    beginTest(*sampling, udp, [] {
+        readCommands(*sampling);
+        sampling->sampleValue_xrp_encoder(0, receives);
+        sampling->sampleValue_xrp_encoder(1, -receives);
+    },
+        [] { writeTelemetry(*sampling, 100); });
+    sampling->MAX_DATAGRAM_SIZE = 200;
+    TEST_ASSERT_EQUAL(0, countAllocationsInUpdate(*sampling, udp));
+    TEST_ASSERT_GREATER_THAN(0, sampling->getStats().telemetryFramesSplit);
+    TEST_ASSERT_GREATER_THAN(0, sampling->getStats().telemetrySamplesSent);
+}
+
+void setUp()
+{
+    comms = new XSWC();
+    sampling = new BasicXSWC<1000, 4000, 16, false, 4, 32>();
+    receives = 0;
+}
+
+void tearDown()
+{
+    delete comms;
+    delete sampling;
+}
+
+int main(int argc, char** argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_update_does_not_allocate);
+    RUN_TEST(test_update_with_split_and_samples_does_not_allocate);
+    return UNITY_END();
+}
@@ -0,0 +1,177 @@
+/*
+ * The batch getters and senders: getValues_* fill an array with channels that have consecutive ids,
+ * and sendValues_* and sendDataArray_* queue several blocks in one call, stopping when the buffer is full.
+ */
+
+#include "../xswc_test.h"
+
+typedef BasicXSWC<1000, 3 + 5 * 7> SmallXSWC; // room for 5 analog blocks
+
+static XSWC* comms = nullptr;
+static MockUDP* udp = nullptr;
+static SmallXSWC* smallComms = nullptr;
+static void (*onSend)(void) = ignoreCallback;
+
+static void sendCallback()
+{
+    onSend();
+}
+
+// receive a packet with the motors, and servo and dio blocks as bytes, then send telemetry
+static MockUDP::Datagram receiveAndSend(std::initializer_list<std::pair<uint8_t, float>> motors, std::initializer_list<uint8_t> blocks = {})
+{
+    static uint16_t sequence = 0;
+    std::vector<uint8_t> packet = commandPacket(sequence++, true, motors);
+    packet.insert(packet.end(), blocks);
+    injectPacket(*udp, packet);
+    advanceMillis(comms->MIN_UPDATE_TIME_MS + 1);
+    udp->sent.clear();
+    comms->update();
+    TEST_ASSERT_EQUAL(1, udp->sent.size());
+    return udp->sent[0];
+}
+
+// the data of the blocks with the tag in a datagram, by id
+static std::vector<std::pair<uint8_t, std::vector<uint8_t>>> blockData(const MockUDP::Datagram& datagram, uint8_t tag)
+{
+    std::vector<std::pair<uint8_t, std::vector<uint8_t>>> found;
+    size_t index = 3;
+    for (const SentBlock& block : blocksOf(datagram)) {
+        if (block.tag == tag) {
+            found.push_back({ block.id, std::vector<uint8_t>(datagram.data.begin() + index + 3, datagram.data.begin() + index + block.size) });
+        }
+        index += block.size;
+    }
+    return found;
+}
+
+void test_get_values_fills_missing_channels()
+{
+    receiveAndSend({ { 0, 0.25f }, { 1, -0.5f }, { 3, 1 } });
+    float values[5] = { 9, 9, 9, 9, 9 };
+    TEST_ASSERT_EQUAL(3, comms->getValues_xrp_motor(values, 5));
+    const float expected[5] = { 0.25f, -0.5f, 0, 1, 0 };
+    for (int i = 0; i < 5; i++) {
+        TEST_ASSERT_EQUAL_FLOAT(expected[i], values[i]);
+    }
+
+    TEST_ASSERT_EQUAL(1, comms->getValues_xrp_motor(values, 3, 2));
+    TEST_ASSERT_EQUAL_FLOAT(0, values[0]);
+    TEST_ASSERT_EQUAL_FLOAT(1, values[1]);
+
+    // past the end of the table nothing can have been received
+    values[0] = 9;
+    TEST_ASSERT_EQUAL(0, comms->getValues_xrp_motor(values, 3, XSWC_MAX_CHANNELS_PER_TAG - 1));
+    TEST_ASSERT_EQUAL_FLOAT(0, values[0]);
+    values[0] = 9;
+    TEST_ASSERT_EQUAL(0, comms->getValues_xrp_motor(values, 2, 200));
+    TEST_ASSERT_EQUAL_FLOAT(0, values[0]);
+}
+
+void test_get_values_of_servos_and_dio()
+{
+    uint8_t servo[7] = { 6, XRP_TAG_SERVO, 1 };
+    floatToNetwork(0.75f, (char*)servo, 3);
+    receiveAndSend({}, { servo[0], servo[1], servo[2], servo[3], servo[4], servo[5], servo[6], 3, XRP_TAG_DIO, 2, 1, 3, XRP_TAG_DIO, 0, 0 });
+    float servos[2];
+    TEST_ASSERT_EQUAL(1, comms->getValues_xrp_servo(servos, 2));
+    TEST_ASSERT_EQUAL_FLOAT(0, servos[0]);
+    TEST_ASSERT_EQUAL_FLOAT(0.75f, servos[1]);
+    bool dio[4] = { true, true, false, true };
+    TEST_ASSERT_EQUAL(2, comms->getValues_xrp_dio(dio, 4));
+    TEST_ASSERT_FALSE(dio[0]);
+    TEST_ASSERT_FALSE(dio[1]);
+    TEST_ASSERT_TRUE(dio[2]);
+    TEST_ASSERT_FALSE(dio[3]);
+}
+
+void test_send_values_queues_consecutive_ids()
+{
+    onSend = [] {
+        const float analog[3] = { 0.5f, 1.5f, 2.5f };
+        TEST_ASSERT_EQUAL(3, comms->sendValues_xrp_analog(analog, 3, 4));
+        const bool dio[2] = { true, false };
+        TEST_ASSERT_EQUAL(2, comms->sendValues_xrp_dio(dio, 2));
+        const int32_t counts[2] = { 100, -200 };
+        TEST_ASSERT_EQUAL(2, comms->sendValues_xrp_encoder(counts, 2, 1));
+    };
+    MockUDP::Datagram sent = receiveAndSend({});
+
+    auto analog = blockData(sent, XRP_TAG_ANALOG);
+    TEST_ASSERT_EQUAL(3, analog.size());
+    for (int i = 0; i < 3; i++) {
+        TEST_ASSERT_EQUAL(4 + i, analog[i].first);
+        TEST_ASSERT_EQUAL_FLOAT(0.5f + i, networkToFloat((const char*)analog[i].second.data(), 0));
+    }
+    auto dio = blockData(sent, XRP_TAG_DIO);
+    TEST_ASSERT_EQUAL(2, dio.size());
+    TEST_ASSERT_EQUAL(1, dio[0].second[0]);
+    TEST_ASSERT_EQUAL(0, dio[1].second[0]);
+    auto encoders = blockData(sent, XRP_TAG_ENCODER);
+    TEST_ASSERT_EQUAL(2, encoders.size());
+    TEST_ASSERT_EQUAL(1, encoders[0].first);
+    TEST_ASSERT_EQUAL(100, networkToInt32((const char*)encoders[0].second.data(), 0));
+    TEST_ASSERT_EQUAL(-200, networkToInt32((const char*)encoders[1].second.data(), 0));
+    TEST_ASSERT_EQUAL(0, networkToInt32((const char*)encoders[1].second.data(), 4)); // period
+    TEST_ASSERT_EQUAL(1, networkToInt32((const char*)encoders[1].second.data(), 8)); // divisor
+}
+
+void test_send_data_array_replaces_earlier_blocks()
+{
+    onSend = [] {
+        const xrp_encoder_t first[2] = { { 0, 1, 2, 3 }, { 5, 4, 5, 6 } };
+        TEST_ASSERT_EQUAL(2, comms->sendDataArray_xrp_encoder(first, 2));
+        const xrp_encoder_t second[2] = { { 5, 7, 8, 9 }, { 6, 10, 11, 12 } };
+        TEST_ASSERT_EQUAL(2, comms->sendDataArray_xrp_encoder(second, 2));
+    };
+    auto encoders = blockData(receiveAndSend({}), XRP_TAG_ENCODER);
+    TEST_ASSERT_EQUAL(3, encoders.size());
+    TEST_ASSERT_EQUAL(5, encoders[1].first);
+    TEST_ASSERT_EQUAL(7, networkToInt32((const char*)encoders[1].second.data(), 0));
+    TEST_ASSERT_EQUAL(9, networkToInt32((const char*)encoders[1].second.data(), 8));
+    TEST_ASSERT_EQUAL(6, encoders[2].first);
+}
+
+void test_send_values_stops_when_the_buffer_is_full()
+{
+    MockUDP smallUdp;
+    static int queued = 0;
+    smallComms = new SmallXSWC();
+    beginTest(*smallComms, smallUdp, ignoreCallback, [] {
+        const float analog[8] = {};
+        queued = smallComms->sendValues_xrp_analog(analog, 8);
+    });
+    injectPacket(smallUdp, commandPacket(0, true));
+    advanceMillis(smallComms->MIN_UPDATE_TIME_MS + 1);
+    smallComms->update();
+    TEST_ASSERT_EQUAL(5, queued);
+    TEST_ASSERT_EQUAL(5, countBlocks(smallUdp.sent[0], XRP_TAG_ANALOG));
+    TEST_ASSERT_EQUAL(1, smallComms->getStats().telemetryBufferFull); // it stops at the first block that doesn't fit
+}
+
+void setUp()
+{
+    comms = new XSWC();
+    udp = new MockUDP();
+    onSend = ignoreCallback;
+    beginTest(*comms, *udp, ignoreCallback, sendCallback);
+}
+
+void tearDown()
+{
+    delete comms;
+    delete udp;
+    delete smallComms;
+    smallComms = nullptr;
+}
+
+int main(int argc, char** argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_get_values_fills_missing_channels);
+    RUN_TEST(test_get_values_of_servos_and_dio);
+    RUN_TEST(test_send_values_queues_consecutive_ids);
+    RUN_TEST(test_send_data_array_replaces_earlier_blocks);
+    RUN_TEST(test_send_values_stops_when_the_buffer_is_full);
+    return UNITY_END();
+}
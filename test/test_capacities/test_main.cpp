@@ -0,0 +1,111 @@
+/*
+ * BasicXSWC's capacities: receiving into the telemetry buffer with SharedBuffer,
+ * and ids too large for MaxChannelsPerTag, which can be sent but not received.
+ */
+
+#include "../xswc_test.h"
+
+typedef BasicXSWC<256, 256, 4, true> SharedXSWC;
+
+static SharedXSWC* comms = nullptr;
+static MockUDP* udp = nullptr;
+
+// the send callback echoes the received motors back as analog inputs, after a block that takes the place of the first received one
+static void echoMotors()
+{
+    comms->sendValue_xrp_analog(2, 9);
+    comms->sendValue_xrp_analog(0, comms->getValue_xrp_motor(0));
+    comms->sendValue_xrp_analog(1, comms->getValue_xrp_motor(1));
+}
+
+static float analogIn(const MockUDP::Datagram& datagram, uint8_t id)
+{
+    size_t index = 3;
+    for (const SentBlock& block : blocksOf(datagram)) {
+        if (block.tag == XRP_TAG_ANALOG && block.id == id) {
+            return networkToFloat((const char*)datagram.data.data(), index + 3);
+        }
+        index += block.size;
+    }
+    return -1;
+}
+
+// receive a packet and send the telemetry right after it, returns the datagram that was sent
+static MockUDP::Datagram receiveAndSend(uint16_t sequence, std::initializer_list<std::pair<uint8_t, float>> motors)
+{
+    injectPacket(*udp, commandPacket(sequence, true, motors));
+    advanceMillis(comms->MIN_UPDATE_TIME_MS + 1);
+    udp->sent.clear();
+    TEST_ASSERT_TRUE(comms->update());
+    TEST_ASSERT_EQUAL(1, udp->sent.size());
+    return udp->sent[0];
+}
+
+void test_shared_buffer_round_trip()
+{
+    MockUDP::Datagram sent = receiveAndSend(0, { { 0, 0.25f }, { 1, -0.5f } });
+    TEST_ASSERT_EQUAL_FLOAT(0.25f, analogIn(sent, 0));
+    TEST_ASSERT_EQUAL_FLOAT(-0.5f, analogIn(sent, 1));
+    // the telemetry overwrote the received packet, the values were decoded before that
+    TEST_ASSERT_EQUAL_FLOAT(0.25f, comms->getValue_xrp_motor(0));
+    TEST_ASSERT_EQUAL_FLOAT(-0.5f, comms->getValue_xrp_motor(1));
+
+    sent = receiveAndSend(1, { { 0, 0.75f } });
+    TEST_ASSERT_EQUAL_FLOAT(0.75f, analogIn(sent, 0));
+    TEST_ASSERT_EQUAL_FLOAT(-0.5f, analogIn(sent, 1)); // kept from the first packet
+    TEST_ASSERT_EQUAL(0, comms->getStats().parseBadSize);
+}
+
+void test_shared_buffer_has_no_task()
+{
+    TEST_ASSERT_FALSE(comms->beginTask());
+    TEST_ASSERT_FALSE(comms->isTaskRunning());
+    TEST_ASSERT_EQUAL_FLOAT(0.25f, analogIn(receiveAndSend(0, { { 0, 0.25f } }), 0)); // update() still works
+}
+
+void test_ids_out_of_range_are_counted()
+{
+    MockUDP::Datagram sent = receiveAndSend(0, { { 0, 0.25f }, { 4, 1 }, { 200, 1 }, { 3, 0.5f } });
+    TEST_ASSERT_EQUAL(2, comms->getStats().parseIdOutOfRange);
+    TEST_ASSERT_EQUAL(0, comms->getStats().parseUnknownTags);
+    TEST_ASSERT_EQUAL_FLOAT(0.25f, analogIn(sent, 0));
+    TEST_ASSERT_EQUAL_FLOAT(0.5f, comms->getValue_xrp_motor(3)); // the blocks after them are still read
+    xrp_motor_t motor;
+    TEST_ASSERT_FALSE(comms->getData_xrp_motor(motor, 4));
+}
+
+void test_ids_out_of_range_can_be_sent()
+{
+    MockUDP sendUdp;
+    SharedXSWC sender;
+    static SharedXSWC* senderComms = &sender;
+    beginTest(sender, sendUdp, ignoreCallback, [] { senderComms->sendValue_xrp_analog(10, 1.5f); });
+    injectPacket(sendUdp, commandPacket(0, true));
+    advanceMillis(sender.MIN_UPDATE_TIME_MS + 1);
+    sender.update();
+    TEST_ASSERT_EQUAL(1, sendUdp.sent.size());
+    TEST_ASSERT_EQUAL_FLOAT(1.5f, analogIn(sendUdp.sent[0], 10));
+}
+
+void setUp()
+{
+    comms = new SharedXSWC();
+    udp = new MockUDP();
+    beginTest(*comms, *udp, ignoreCallback, echoMotors);
+}
+
+void tearDown()
+{
+    delete comms;
+    delete udp;
+}
+
+int main(int argc, char** argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_shared_buffer_round_trip);
+    RUN_TEST(test_shared_buffer_has_no_task);
+    RUN_TEST(test_ids_out_of_range_are_counted);
+    RUN_TEST(test_ids_out_of_range_can_be_sent);
+    return UNITY_END();
+}
@@ -0,0 +1,178 @@
+/*
+ * deltaTelemetry: blocks are only sent when their value changed by more than the deadband,
+ * with every block sent again in keyframes, after connecting and after a send that failed.
+ */
+
+#include "../xswc_test.h"
+
+// a MockUDP whose endPacket() fails when asked to, like when the network stack is out of buffers
+class FlakyUDP : public MockUDP {
+public:
+    int endPacket() override
+    {
+        if (failNext) {
+            failNext = false;
+            return 0;
+        }
+        return MockUDP::endPacket();
+    }
+
+    bool failNext = false;
+};
+
+static XSWC* comms = nullptr;
+static FlakyUDP* udp = nullptr;
+static uint16_t sequence = 0;
+static float analog[3];
+static float yaw = 0;
+
+static void sendTelemetry()
+{
+    comms->sendValues_xrp_analog(analog, 3);
+    comms->sendValue_xrp_gyro(0, 0, 0, 0, 0, yaw);
+}
+
+// a command keeps the link up, then telemetry is sent, returns the last datagram
+static MockUDP::Datagram sendOnce()
+{
+    injectPacket(*udp, commandPacket(sequence++, true));
+    advanceMillis(comms->MIN_UPDATE_TIME_MS + 1);
+    size_t before = udp->sent.size();
+    comms->update();
+    TEST_ASSERT_GREATER_THAN(before, udp->sent.size());
+    return udp->sent.back();
+}
+
+static bool hasAnalog(const MockUDP::Datagram& datagram, uint8_t id)
+{
+    for (const SentBlock& block : blocksOf(datagram)) {
+        if (block.tag == XRP_TAG_ANALOG && block.id == id) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void test_every_block_is_sent_without_delta()
+{
+    comms->deltaTelemetry = false;
+    for (int i = 0; i < 5; i++) {
+        MockUDP::Datagram sent = sendOnce();
+        TEST_ASSERT_EQUAL(3, countBlocks(sent, XRP_TAG_ANALOG));
+        TEST_ASSERT_EQUAL(1, countBlocks(sent, XRP_TAG_GYRO));
+    }
+    TEST_ASSERT_EQUAL(0, comms->getStats().telemetryBlocksSkipped);
+}
+
+void test_unchanged_blocks_are_skipped()
+{
+    MockUDP::Datagram first = sendOnce(); // the first send after connecting has everything
+    TEST_ASSERT_EQUAL(3, countBlocks(first, XRP_TAG_ANALOG));
+    TEST_ASSERT_EQUAL(1, countBlocks(first, XRP_TAG_GYRO));
+
+    MockUDP::Datagram second = sendOnce();
+    TEST_ASSERT_EQUAL(3, second.data.size()); // only the header
+    XSWC::Stats stats = comms->getStats();
+    TEST_ASSERT_EQUAL(4, stats.telemetryBlocksSkipped);
+    TEST_ASSERT_EQUAL(3 * 7 + 26, stats.telemetryBytesSaved);
+
+    analog[1] = 0.5f;
+    yaw = 90;
+    MockUDP::Datagram third = sendOnce();
+    TEST_ASSERT_EQUAL(1, countBlocks(third, XRP_TAG_ANALOG));
+    TEST_ASSERT_TRUE(hasAnalog(third, 1));
+    TEST_ASSERT_EQUAL(1, countBlocks(third, XRP_TAG_GYRO));
+}
+
+void test_deadband_is_measured_from_the_last_sent_value()
+{
+    comms->TELEMETRY_DEADBAND = 0.1f;
+    TEST_ASSERT_TRUE(comms->setTelemetryDeadband(XRP_TAG_ANALOG, 2, 1.0f));
+    TEST_ASSERT_FALSE(comms->setTelemetryDeadband(XRP_TAG_ANALOG, 200, 1.0f));
+    TEST_ASSERT_FALSE(comms->setTelemetryDeadband(0x01, 0, 1.0f));
+    sendOnce();
+
+    // small steps that are each within the deadband, but add up to more than it
+    for (int i = 1; i <= 6; i++) {
+        analog[0] = i * 0.04f;
+        analog[2] = i * 0.3f;
+        MockUDP::Datagram sent = sendOnce();
+        TEST_ASSERT_EQUAL(i == 3 || i == 6, hasAnalog(sent, 0)); // 0.12 is more than 0.1 from 0, then 0.24 from 0.12
+        TEST_ASSERT_EQUAL(i == 4, hasAnalog(sent, 2)); // 1.2 is more than 1 from 0
+    }
+}
+
+void test_keyframe_every_interval()
+{
+    comms->TELEMETRY_KEYFRAME_INTERVAL = 5;
+    sendOnce();
+    for (int i = 1; i <= 15; i++) {
+        MockUDP::Datagram sent = sendOnce();
+        TEST_ASSERT_EQUAL(i % 5 == 0 ? 3 : 0, countBlocks(sent, XRP_TAG_ANALOG));
+    }
+}
+
+void test_keyframe_after_reconnecting()
+{
+    sendOnce();
+    TEST_ASSERT_EQUAL(0, countBlocks(sendOnce(), XRP_TAG_ANALOG));
+    advanceMillis(comms->TIMEOUT_MS);
+    comms->update();
+    TEST_ASSERT_FALSE(comms->isConnected());
+    TEST_ASSERT_EQUAL(3, countBlocks(sendOnce(), XRP_TAG_ANALOG));
+    TEST_ASSERT_EQUAL(0, countBlocks(sendOnce(), XRP_TAG_ANALOG));
+}
+
+void test_keyframe_for_a_new_subscriber()
+{
+    sendOnce();
+    TEST_ASSERT_EQUAL(0, countBlocks(sendOnce(), XRP_TAG_ANALOG));
+    TEST_ASSERT_TRUE(comms->addTelemetrySubscriber(IPAddress(127, 0, 0, 9), 3540));
+    MockUDP::Datagram sent = sendOnce(); // the last of the two datagrams, to the subscriber
+    TEST_ASSERT_TRUE(sent.addr == IPAddress(127, 0, 0, 9));
+    TEST_ASSERT_EQUAL(3, countBlocks(sent, XRP_TAG_ANALOG));
+}
+
+void test_value_is_sent_again_after_a_failed_send()
+{
+    sendOnce();
+    analog[0] = 2;
+    udp->failNext = true;
+    injectPacket(*udp, commandPacket(sequence++, true));
+    advanceMillis(comms->MIN_UPDATE_TIME_MS + 1);
+    comms->update();
+    TEST_ASSERT_EQUAL(1, comms->getStats().telemetrySendFailures);
+
+    MockUDP::Datagram sent = sendOnce(); // the value didn't change since the failed send, but it never arrived
+    TEST_ASSERT_TRUE(hasAnalog(sent, 0));
+    TEST_ASSERT_FALSE(hasAnalog(sendOnce(), 0));
+}
+
+void setUp()
+{
+    comms = new XSWC();
+    udp = new FlakyUDP();
+    beginTest(*comms, *udp, ignoreCallback, sendTelemetry);
+    comms->deltaTelemetry = true;
+    analog[0] = analog[1] = analog[2] = 0;
+    yaw = 0;
+}
+
+void tearDown()
+{
+    delete comms;
+    delete udp;
+}
+
+int main(int argc, char** argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_every_block_is_sent_without_delta);
+    RUN_TEST(test_unchanged_blocks_are_skipped);
+    RUN_TEST(test_deadband_is_measured_from_the_last_sent_value);
+    RUN_TEST(test_keyframe_every_interval);
+    RUN_TEST(test_keyframe_after_reconnecting);
+    RUN_TEST(test_keyframe_for_a_new_subscriber);
+    RUN_TEST(test_value_is_sent_again_after_a_failed_send);
+    return UNITY_END();
+}
@@ -0,0 +1,113 @@
+/*
+ * Packets that queued up while update() wasn't called are all read by the next update(), oldest first,
+ * with the receive callback run once for the newest commands.
+ */
+
+#include "../xswc_test.h"
+
+static XSWC* comms = nullptr;
+static MockUDP* udp = nullptr;
+static int receives = 0;
+static std::vector<float> handled; // motor 0 values in the order the handler saw them
+
+static void countReceive()
+{
+    receives++;
+}
+
+static void onMotor(const xrp_motor_t& data, void* context)
+{
+    handled.push_back(data.value);
+}
+
+void test_backlog_is_read_in_one_update()
+{
+    for (uint16_t sequence = 0; sequence < 10; sequence++) {
+        injectPacket(*udp, commandPacket(sequence, true, { { 0, sequence * 0.1f } }));
+    }
+    advanceMillis(500); // the loop was stalled
+    TEST_ASSERT_TRUE(comms->update());
+    TEST_ASSERT_EQUAL(1, receives);
+    TEST_ASSERT_EQUAL_FLOAT(0.9f, comms->getValue_xrp_motor(0));
+    XSWC::Stats stats = comms->getStats();
+    TEST_ASSERT_EQUAL(10, stats.packetsReceived);
+    TEST_ASSERT_EQUAL(9, stats.packetsCoalesced);
+    TEST_ASSERT_EQUAL(0, stats.packetsLost);
+
+    advanceMillis(20);
+    TEST_ASSERT_FALSE(comms->update()); // nothing left over for the next loop
+    TEST_ASSERT_EQUAL(1, receives);
+}
+
+void test_packets_are_applied_oldest_first()
+{
+    comms->onReceive_xrp_motor(0, onMotor);
+    injectPacket(*udp, commandPacket(0, true, { { 0, 0.1f }, { 1, 0.5f } }));
+    injectPacket(*udp, commandPacket(1, true, { { 0, 0.2f } }));
+    injectPacket(*udp, commandPacket(2, false, { { 0, 0.3f } }));
+    advanceMillis(20);
+    TEST_ASSERT_TRUE(comms->update());
+    TEST_ASSERT_EQUAL(3, handled.size());
+    TEST_ASSERT_EQUAL_FLOAT(0.1f, handled[0]);
+    TEST_ASSERT_EQUAL_FLOAT(0.2f, handled[1]);
+    TEST_ASSERT_EQUAL_FLOAT(0.3f, handled[2]);
+    TEST_ASSERT_EQUAL_FLOAT(0.3f, comms->getValue_xrp_motor(0));
+    TEST_ASSERT_EQUAL_FLOAT(0.5f, comms->getValue_xrp_motor(1)); // only the oldest packet had motor 1
+    TEST_ASSERT_FALSE(comms->isEnabled()); // the newest packet decides
+}
+
+void test_reads_are_limited_per_update()
+{
+    comms->MAX_PACKETS_PER_UPDATE = 4;
+    for (uint16_t sequence = 0; sequence < 10; sequence++) {
+        injectPacket(*udp, commandPacket(sequence, true, { { 0, sequence } }));
+    }
+    const float newest[] = { 3, 7, 9 };
+    for (float value : newest) {
+        advanceMillis(20);
+        TEST_ASSERT_TRUE(comms->update());
+        TEST_ASSERT_EQUAL_FLOAT(value, comms->getValue_xrp_motor(0));
+    }
+    TEST_ASSERT_EQUAL(3, receives);
+    TEST_ASSERT_EQUAL(10, comms->getStats().packetsReceived);
+    TEST_ASSERT_EQUAL(0, comms->getStats().packetsReordered);
+}
+
+void test_one_packet_per_update()
+{
+    comms->MAX_PACKETS_PER_UPDATE = 1;
+    for (uint16_t sequence = 0; sequence < 3; sequence++) {
+        injectPacket(*udp, commandPacket(sequence, true, { { 0, sequence } }));
+    }
+    for (int value = 0; value < 3; value++) {
+        advanceMillis(20);
+        TEST_ASSERT_TRUE(comms->update());
+        TEST_ASSERT_EQUAL_FLOAT(value, comms->getValue_xrp_motor(0));
+    }
+    TEST_ASSERT_EQUAL(0, comms->getStats().packetsCoalesced);
+}
+
+void setUp()
+{
+    comms = new XSWC();
+    udp = new MockUDP();
+    receives = 0;
+    handled.clear();
+    beginTest(*comms, *udp, countReceive);
+}
+
+void tearDown()
+{
+    delete comms;
+    delete udp;
+}
+
+int main(int argc, char** argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_backlog_is_read_in_one_update);
+    RUN_TEST(test_packets_are_applied_oldest_first);
+    RUN_TEST(test_reads_are_limited_per_update);
+    RUN_TEST(test_one_packet_per_update);
+    return UNITY_END();
+}
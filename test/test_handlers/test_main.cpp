@@ -0,0 +1,137 @@
+/*
+ * Receive handlers and bindings without the communication task: they're called while the packet is parsed,
+ * once for each block of their channel, before the receive callback.
+ */
+
+#include "../xswc_test.h"
+
+#include <string>
+
+static XSWC* comms = nullptr;
+static MockUDP* udp = nullptr;
+static uint16_t sequence = 0;
+static std::string events; // what was called, in order
+
+static void onReceive()
+{
+    events += "callback ";
+}
+
+static void onMotor(const xrp_motor_t& data, void* context)
+{
+    events += "motor" + std::to_string(data.id) + " ";
+    *(float*)context = data.value;
+}
+
+static void onDio(const xrp_dio_t& data, void* context)
+{
+    events += data.value ? "dio-on " : "dio-off ";
+}
+
+static void receive(std::initializer_list<std::pair<uint8_t, float>> motors, std::initializer_list<uint8_t> blocks = {})
+{
+    std::vector<uint8_t> packet = commandPacket(sequence++, true, motors);
+    packet.insert(packet.end(), blocks);
+    injectPacket(*udp, packet);
+    advanceMillis(20);
+    comms->update();
+}
+
+void test_handlers_run_while_parsing()
+{
+    float motor0 = 0;
+    float motor2 = 0;
+    TEST_ASSERT_TRUE(comms->onReceive_xrp_motor(0, onMotor, &motor0));
+    TEST_ASSERT_TRUE(comms->onReceive_xrp_motor(2, onMotor, &motor2));
+    TEST_ASSERT_TRUE(comms->onReceive_xrp_dio(1, onDio));
+    receive({ { 2, 0.5f }, { 1, 1 }, { 0, 0.25f } }, { 3, XRP_TAG_DIO, 1, 1 });
+    TEST_ASSERT_EQUAL_STRING("motor2 motor0 dio-on callback ", events.c_str());
+    TEST_ASSERT_EQUAL_FLOAT(0.25f, motor0);
+    TEST_ASSERT_EQUAL_FLOAT(0.5f, motor2);
+
+    events.clear();
+    receive({ { 1, 1 } });
+    TEST_ASSERT_EQUAL_STRING("callback ", events.c_str()); // no handler for motor 1
+}
+
+void test_bindings_write_variables()
+{
+    float motor = 0;
+    float servo = 0;
+    bool dio = false;
+    float analog = 0;
+    TEST_ASSERT_TRUE(comms->bind_xrp_motor(3, motor));
+    TEST_ASSERT_TRUE(comms->bind_xrp_servo(0, servo));
+    TEST_ASSERT_TRUE(comms->bind_xrp_dio(2, dio));
+    TEST_ASSERT_TRUE(comms->bind_xrp_analog(1, analog));
+    uint8_t servoBlock[7] = { 6, XRP_TAG_SERVO, 0 };
+    floatToNetwork(0.75f, (char*)servoBlock, 3);
+    uint8_t analogBlock[7] = { 6, XRP_TAG_ANALOG, 1 };
+    floatToNetwork(2.5f, (char*)analogBlock, 3);
+    receive({ { 3, -1 } }, { servoBlock[0], servoBlock[1], servoBlock[2], servoBlock[3], servoBlock[4], servoBlock[5], servoBlock[6],
+                               3, XRP_TAG_DIO, 2, 1,
+                               analogBlock[0], analogBlock[1], analogBlock[2], analogBlock[3], analogBlock[4], analogBlock[5], analogBlock[6] });
+    TEST_ASSERT_EQUAL_FLOAT(-1, motor);
+    TEST_ASSERT_EQUAL_FLOAT(0.75f, servo);
+    TEST_ASSERT_TRUE(dio);
+    TEST_ASSERT_EQUAL_FLOAT(2.5f, analog);
+}
+
+void test_every_drained_packet_reaches_the_handler()
+{
+    float motor = 0;
+    comms->onReceive_xrp_motor(0, onMotor, &motor);
+    for (int i = 0; i < 3; i++) {
+        injectPacket(*udp, commandPacket(sequence++, true, { { 0, (float)i } }));
+    }
+    advanceMillis(20);
+    comms->update();
+    TEST_ASSERT_EQUAL_STRING("motor0 motor0 motor0 callback ", events.c_str());
+    TEST_ASSERT_EQUAL_FLOAT(2, motor);
+}
+
+void test_removed_handler_is_not_called()
+{
+    float motor = 0;
+    comms->bind_xrp_motor(0, motor);
+    receive({ { 0, 0.5f } });
+    TEST_ASSERT_TRUE(comms->onReceive_xrp_motor(0, nullptr));
+    receive({ { 0, 1 } });
+    TEST_ASSERT_EQUAL_FLOAT(0.5f, motor);
+    TEST_ASSERT_EQUAL_FLOAT(1, comms->getValue_xrp_motor(0)); // still received as usual
+}
+
+void test_ids_that_cant_be_received_are_refused()
+{
+    float motor = 0;
+    TEST_ASSERT_FALSE(comms->bind_xrp_motor(XSWC_MAX_CHANNELS_PER_TAG, motor));
+    TEST_ASSERT_FALSE(comms->onReceive_xrp_motor(200, onMotor, &motor));
+    TEST_ASSERT_TRUE(comms->onReceive_xrp_motor(0, nullptr)); // removing a handler that was never added
+    receive({ { 200, 1 } });
+    TEST_ASSERT_EQUAL_STRING("callback ", events.c_str());
+}
+
+void setUp()
+{
+    comms = new XSWC();
+    udp = new MockUDP();
+    events.clear();
+    beginTest(*comms, *udp, onReceive);
+}
+
+void tearDown()
+{
+    delete comms;
+    delete udp;
+}
+
+int main(int argc, char** argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_handlers_run_while_parsing);
+    RUN_TEST(test_bindings_write_variables);
+    RUN_TEST(test_every_drained_packet_reaches_the_handler);
+    RUN_TEST(test_removed_handler_is_not_called);
+    RUN_TEST(test_ids_that_cant_be_received_are_refused);
+    return UNITY_END();
+}
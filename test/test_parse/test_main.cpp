@@ -0,0 +1,106 @@
+/*
+ * Parsing received packets: blocks with tags that can't be received are skipped by their size byte,
+ * a block with a wrong size stops the rest of the packet, and blocks are only decoded when they're read.
+ */
+
+#include "../xswc_test.h"
+
+static XSWC* comms = nullptr;
+static MockUDP* udp = nullptr;
+static uint16_t sequence = 0;
+
+// a command packet with the motors, then extra bytes appended as they are
+static std::vector<uint8_t> packetWith(std::initializer_list<std::pair<uint8_t, float>> motors, std::initializer_list<uint8_t> extra, std::initializer_list<std::pair<uint8_t, float>> motorsAfter = {})
+{
+    std::vector<uint8_t> packet = commandPacket(sequence++, true, motors);
+    packet.insert(packet.end(), extra);
+    std::vector<uint8_t> after = commandPacket(0, true, motorsAfter);
+    packet.insert(packet.end(), after.begin() + 3, after.end());
+    return packet;
+}
+
+static bool receive(const std::vector<uint8_t>& packet)
+{
+    injectPacket(*udp, packet);
+    advanceMillis(20);
+    return comms->update();
+}
+
+void test_unknown_tags_are_skipped_by_their_size()
+{
+    // an unknown tag, and a tag wpilib only receives, each between two motor blocks
+    TEST_ASSERT_TRUE(receive(packetWith({ { 0, 0.25f } }, { 4, 0x7F, 1, 2, 3, 6, XRP_TAG_ENCODER, 0, 0, 0, 0, 5 }, { { 1, 0.5f } })));
+    TEST_ASSERT_EQUAL_FLOAT(0.25f, comms->getValue_xrp_motor(0));
+    TEST_ASSERT_EQUAL_FLOAT(0.5f, comms->getValue_xrp_motor(1));
+    XSWC::Stats stats = comms->getStats();
+    TEST_ASSERT_EQUAL(2, stats.parseUnknownTags);
+    TEST_ASSERT_EQUAL(0, stats.parseBadSize);
+}
+
+void test_truncated_unknown_block_ends_the_packet()
+{
+    // the size byte says 20 bytes follow, but the packet ends after 3
+    TEST_ASSERT_TRUE(receive(packetWith({ { 0, 0.25f } }, { 20, 0x7F, 1, 2 })));
+    TEST_ASSERT_EQUAL_FLOAT(0.25f, comms->getValue_xrp_motor(0));
+    TEST_ASSERT_EQUAL(1, comms->getStats().parseUnknownTags);
+    TEST_ASSERT_EQUAL(0, comms->getStats().parseBadSize);
+
+    // the same with only the size byte left
+    TEST_ASSERT_TRUE(receive(packetWith({ { 0, 0.5f } }, { 20 })));
+    TEST_ASSERT_EQUAL_FLOAT(0.5f, comms->getValue_xrp_motor(0));
+    TEST_ASSERT_EQUAL(0, comms->getStats().parseBadSize);
+}
+
+void test_bad_size_stops_the_packet()
+{
+    TEST_ASSERT_TRUE(receive(packetWith({ { 0, 0.25f } }, { 0, 0x7F }, { { 1, 0.5f } }))); // a size of 0
+    TEST_ASSERT_EQUAL_FLOAT(0.25f, comms->getValue_xrp_motor(0));
+    xrp_motor_t motor;
+    TEST_ASSERT_FALSE(comms->getData_xrp_motor(motor, 1));
+    TEST_ASSERT_EQUAL(1, comms->getStats().parseBadSize);
+
+    // a motor block that says it's longer than a motor block
+    receive(packetWith({}, { 9, XRP_TAG_MOTOR, 2, 0, 0, 0, 0, 0, 0, 0 }, { { 3, 0.5f } }));
+    TEST_ASSERT_FALSE(comms->getData_xrp_motor(motor, 2));
+    TEST_ASSERT_FALSE(comms->getData_xrp_motor(motor, 3));
+    TEST_ASSERT_EQUAL(2, comms->getStats().parseBadSize);
+
+    // a motor block cut off by the end of the packet
+    receive(packetWith({}, { 6, XRP_TAG_MOTOR, 2, 0, 0 }));
+    TEST_ASSERT_FALSE(comms->getData_xrp_motor(motor, 2));
+    TEST_ASSERT_EQUAL(3, comms->getStats().parseBadSize);
+}
+
+void test_values_survive_the_next_packet()
+{
+    // the first packet's blocks are only indexed, reading the next packet into the buffer mustn't lose them
+    receive(packetWith({ { 0, 0.25f }, { 1, 0.5f } }, {}));
+    receive(packetWith({ { 1, 0.75f } }, {}));
+    receive(packetWith({ { 2, 1 } }, {}));
+    TEST_ASSERT_EQUAL_FLOAT(0.25f, comms->getValue_xrp_motor(0));
+    TEST_ASSERT_EQUAL_FLOAT(0.75f, comms->getValue_xrp_motor(1));
+    TEST_ASSERT_EQUAL_FLOAT(1, comms->getValue_xrp_motor(2));
+}
+
+void setUp()
+{
+    comms = new XSWC();
+    udp = new MockUDP();
+    beginTest(*comms, *udp);
+}
+
+void tearDown()
+{
+    delete comms;
+    delete udp;
+}
+
+int main(int argc, char** argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_unknown_tags_are_skipped_by_their_size);
+    RUN_TEST(test_truncated_unknown_block_ends_the_packet);
+    RUN_TEST(test_bad_size_stops_the_packet);
+    RUN_TEST(test_values_survive_the_next_packet);
+    return UNITY_END();
+}
@@ -0,0 +1,123 @@
+/*
+ * adaptiveTelemetryRate: telemetry is sent as often as commands arrive, the interval doubles when packets
+ * are lost or endPacket() fails, and then returns to the command rate gradually.
+ */
+
+#include "../xswc_test.h"
+
+// a MockUDP whose endPacket() fails when asked to, like when the network stack is out of buffers
+class FlakyUDP : public MockUDP {
+public:
+    int endPacket() override
+    {
+        if (failNext) {
+            failNext = false;
+            return 0;
+        }
+        return MockUDP::endPacket();
+    }
+
+    bool failNext = false;
+};
+
+static XSWC* comms = nullptr;
+static FlakyUDP* udp = nullptr;
+static uint16_t sequence = 0;
+
+// a command every periodMs milliseconds, with update() called every millisecond
+static void receiveEvery(unsigned long periodMs, int packets)
+{
+    for (int i = 0; i < packets; i++) {
+        injectPacket(*udp, commandPacket(sequence++, true));
+        for (unsigned long ms = 0; ms < periodMs; ms++) {
+            comms->update();
+            advanceMillis(1);
+        }
+    }
+}
+
+void test_interval_follows_the_commands()
+{
+    TEST_ASSERT_EQUAL(comms->MIN_UPDATE_TIME_MS, comms->getTelemetryIntervalMs()); // nothing measured yet
+    receiveEvery(10, 50);
+    TEST_ASSERT_EQUAL(10, comms->getTelemetryIntervalMs());
+    udp->sent.clear();
+    receiveEvery(10, 10);
+    TEST_ASSERT_EQUAL(10, udp->sent.size());
+
+    receiveEvery(1, 50);
+    TEST_ASSERT_EQUAL(comms->MIN_TELEMETRY_INTERVAL_MS, comms->getTelemetryIntervalMs());
+    receiveEvery(150, 30);
+    TEST_ASSERT_GREATER_OR_EQUAL(145, comms->getTelemetryIntervalMs()); // the measured interval is averaged
+    TEST_ASSERT_LESS_OR_EQUAL(150, comms->getTelemetryIntervalMs());
+}
+
+void test_loss_backs_off_then_recovers()
+{
+    receiveEvery(10, 50);
+    sequence += 3; // lost
+    receiveEvery(10, 2);
+    TEST_ASSERT_EQUAL(20, comms->getTelemetryIntervalMs());
+    receiveEvery(10, 50);
+    TEST_ASSERT_EQUAL(10, comms->getTelemetryIntervalMs());
+
+    // doubling stops at the maximum
+    comms->MAX_TELEMETRY_INTERVAL_MS = 30;
+    for (int i = 0; i < 3; i++) {
+        sequence += 2;
+        receiveEvery(10, 4);
+    }
+    TEST_ASSERT_EQUAL(30, comms->getTelemetryIntervalMs());
+}
+
+void test_send_failure_backs_off()
+{
+    receiveEvery(10, 50);
+    udp->failNext = true;
+    receiveEvery(10, 2);
+    TEST_ASSERT_EQUAL(20, comms->getTelemetryIntervalMs());
+}
+
+void test_loss_after_reset_stats_backs_off()
+{
+    receiveEvery(10, 50);
+    sequence += 5;
+    udp->failNext = true;
+    receiveEvery(10, 50); // backs off, and recovers
+    TEST_ASSERT_EQUAL(10, comms->getTelemetryIntervalMs());
+
+    comms->resetStats();
+    sequence += 1; // less than was lost before the reset
+    receiveEvery(10, 2);
+    TEST_ASSERT_EQUAL(1, comms->getStats().packetsLost);
+    TEST_ASSERT_EQUAL(20, comms->getTelemetryIntervalMs());
+    receiveEvery(10, 50);
+    udp->failNext = true;
+    receiveEvery(10, 2);
+    TEST_ASSERT_EQUAL(20, comms->getTelemetryIntervalMs());
+}
+
+void setUp()
+{
+    comms = new XSWC();
+    udp = new FlakyUDP();
+    udp->keepSent = true;
+    beginTest(*comms, *udp);
+    comms->adaptiveTelemetryRate = true;
+}
+
+void tearDown()
+{
+    delete comms;
+    delete udp;
+}
+
+int main(int argc, char** argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_interval_follows_the_commands);
+    RUN_TEST(test_loss_backs_off_then_recovers);
+    RUN_TEST(test_send_failure_backs_off);
+    RUN_TEST(test_loss_after_reset_stats_backs_off);
+    return UNITY_END();
+}
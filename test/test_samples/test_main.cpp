@@ -0,0 +1,163 @@
+/*
+ * sendSampleBatches: every sample passed to the sampleData methods since the last send follows the normal blocks
+ * in XSWC_TAG_SAMPLE_BATCH blocks, each with a micros() timestamp, oldest first, split over as many blocks as needed.
+ */
+
+#include "../xswc_test.h"
+
+typedef BasicXSWC<1000, 2000, 16, false, 4, 32> SamplingXSWC;
+
+static const int ENCODER_SAMPLE_SIZE = 4 + 13; // timestamp, id, count, period, divisor
+static const int GYRO_SAMPLE_SIZE = 4 + 24; // timestamp, 3 rates, 3 angles
+
+static SamplingXSWC* comms = nullptr;
+static MockUDP* udp = nullptr;
+
+struct SampleBatch {
+    uint8_t sampledTag;
+    std::vector<uint8_t> samples; // the bytes after the sampled tag
+};
+
+// the XSWC_TAG_SAMPLE_BATCH blocks of a datagram
+static std::vector<SampleBatch> batchesOf(const MockUDP::Datagram& datagram)
+{
+    std::vector<SampleBatch> batches;
+    size_t index = 3;
+    for (const SentBlock& block : blocksOf(datagram)) {
+        if (block.tag == XSWC_TAG_SAMPLE_BATCH) {
+            batches.push_back({ block.id, std::vector<uint8_t>(datagram.data.begin() + index + 3, datagram.data.begin() + index + block.size) });
+        }
+        index += block.size;
+    }
+    return batches;
+}
+
+// take an encoder sample every millisecond
+static void sampleEncoder(int samples, int firstCount = 0)
+{
+    for (int i = 0; i < samples; i++) {
+        comms->sampleValue_xrp_encoder(1, firstCount + i, 7);
+        advanceMillis(1);
+    }
+}
+
+// send telemetry after a command, returns the datagram
+static MockUDP::Datagram sendOnce()
+{
+    static uint16_t sequence = 0;
+    injectPacket(*udp, commandPacket(sequence++, true));
+    advanceMillis(comms->MIN_UPDATE_TIME_MS + 1);
+    udp->sent.clear();
+    comms->update();
+    TEST_ASSERT_EQUAL(1, udp->sent.size());
+    return udp->sent[0];
+}
+
+void test_batch_layout()
+{
+    unsigned long firstMicros = testMicros;
+    sampleEncoder(3, 100);
+    MockUDP::Datagram sent = sendOnce();
+
+    // the newest sample is also sent in the normal block
+    TEST_ASSERT_EQUAL(1, countBlocks(sent, XRP_TAG_ENCODER));
+    std::vector<SampleBatch> batches = batchesOf(sent);
+    TEST_ASSERT_EQUAL(1, batches.size());
+    TEST_ASSERT_EQUAL(XRP_TAG_ENCODER, batches[0].sampledTag);
+    TEST_ASSERT_EQUAL(3 * ENCODER_SAMPLE_SIZE, batches[0].samples.size());
+    const char* samples = (const char*)batches[0].samples.data();
+    for (int i = 0; i < 3; i++) {
+        int offset = i * ENCODER_SAMPLE_SIZE;
+        TEST_ASSERT_EQUAL(firstMicros + i * 1000, networkToUInt32(samples, offset));
+        TEST_ASSERT_EQUAL(1, (uint8_t)samples[offset + 4]); // id
+        TEST_ASSERT_EQUAL(100 + i, networkToInt32(samples, offset + 5)); // count
+        TEST_ASSERT_EQUAL(7, networkToInt32(samples, offset + 9)); // period
+        TEST_ASSERT_EQUAL(1, networkToInt32(samples, offset + 13)); // divisor
+    }
+    TEST_ASSERT_EQUAL(3, comms->getStats().telemetrySamplesSent);
+
+    // the samples were sent, they aren't sent again
+    TEST_ASSERT_EQUAL(0, batchesOf(sendOnce()).size());
+}
+
+void test_gyro_batch_layout()
+{
+    xrp_gyro_t gyro = { { 1, 2, 3 }, { 4, 5, 6 } };
+    comms->sampleData_xrp_gyro(gyro);
+    std::vector<SampleBatch> batches = batchesOf(sendOnce());
+    TEST_ASSERT_EQUAL(1, batches.size());
+    TEST_ASSERT_EQUAL(XRP_TAG_GYRO, batches[0].sampledTag);
+    TEST_ASSERT_EQUAL(GYRO_SAMPLE_SIZE, batches[0].samples.size());
+    for (int i = 0; i < 6; i++) {
+        TEST_ASSERT_EQUAL_FLOAT(i + 1, networkToFloat((const char*)batches[0].samples.data(), 4 + i * 4));
+    }
+}
+
+void test_samples_are_split_across_blocks()
+{
+    const int encodersPerBlock = (255 - 2) / ENCODER_SAMPLE_SIZE;
+    sampleEncoder(20);
+    for (int i = 0; i < 10; i++) {
+        comms->sampleData_xrp_gyro(xrp_gyro_t { { (float)i, 0, 0 }, { 0, 0, 0 } });
+    }
+    std::vector<SampleBatch> batches = batchesOf(sendOnce());
+    TEST_ASSERT_EQUAL(4, batches.size());
+    TEST_ASSERT_EQUAL(encodersPerBlock * ENCODER_SAMPLE_SIZE, batches[0].samples.size());
+    TEST_ASSERT_EQUAL((20 - encodersPerBlock) * ENCODER_SAMPLE_SIZE, batches[1].samples.size());
+    TEST_ASSERT_EQUAL(XRP_TAG_GYRO, batches[2].sampledTag);
+    TEST_ASSERT_EQUAL((255 - 2) / GYRO_SAMPLE_SIZE * GYRO_SAMPLE_SIZE, batches[2].samples.size());
+    TEST_ASSERT_EQUAL(GYRO_SAMPLE_SIZE, batches[3].samples.size());
+    // the second block continues where the first one stopped
+    TEST_ASSERT_EQUAL(encodersPerBlock, networkToInt32((const char*)batches[1].samples.data(), 5));
+    TEST_ASSERT_EQUAL_FLOAT(9, networkToFloat((const char*)batches[3].samples.data(), 4));
+    TEST_ASSERT_EQUAL(30, comms->getStats().telemetrySamplesSent);
+}
+
+void test_oldest_samples_are_dropped_when_the_buffer_is_full()
+{
+    sampleEncoder(40);
+    std::vector<SampleBatch> batches = batchesOf(sendOnce());
+    int samples = 0;
+    for (const SampleBatch& batch : batches) {
+        samples += batch.samples.size() / ENCODER_SAMPLE_SIZE;
+    }
+    TEST_ASSERT_EQUAL(32, samples);
+    TEST_ASSERT_EQUAL(8, networkToInt32((const char*)batches[0].samples.data(), 5)); // the first 8 were replaced
+    TEST_ASSERT_EQUAL(8, comms->getStats().telemetrySamplesDropped);
+}
+
+void test_nothing_is_kept_without_send_sample_batches()
+{
+    comms->sendSampleBatches = false;
+    sampleEncoder(5);
+    MockUDP::Datagram sent = sendOnce();
+    TEST_ASSERT_EQUAL(1, countBlocks(sent, XRP_TAG_ENCODER));
+    TEST_ASSERT_EQUAL(0, batchesOf(sent).size());
+    comms->sendSampleBatches = true;
+    TEST_ASSERT_EQUAL(0, batchesOf(sendOnce()).size());
+}
+
+void setUp()
+{
+    comms = new SamplingXSWC();
+    udp = new MockUDP();
+    beginTest(*comms, *udp);
+    comms->sendSampleBatches = true;
+}
+
+void tearDown()
+{
+    delete comms;
+    delete udp;
+}
+
+int main(int argc, char** argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_batch_layout);
+    RUN_TEST(test_gyro_batch_layout);
+    RUN_TEST(test_samples_are_split_across_blocks);
+    RUN_TEST(test_oldest_samples_are_dropped_when_the_buffer_is_full);
+    RUN_TEST(test_nothing_is_kept_without_send_sample_batches);
+    return UNITY_END();
+}
@@ -0,0 +1,164 @@
+/*
+ * Sequence number tracking: lost, duplicated and reordered packets are counted,
+ * and a packet older than one already applied never overwrites newer values.
+ */
+
+#include "../xswc_test.h"
+
+static XSWC* comms = nullptr;
+static MockUDP* udp = nullptr;
+static int receives = 0;
+
+static void countReceive()
+{
+    receives++;
+}
+
+// deliver one packet that sets motor 0 to value, returns whether it was applied
+static bool receive(uint16_t sequence, float value, IPAddress from = IPAddress(127, 0, 0, 1))
+{
+    injectPacket(*udp, commandPacket(sequence, true, { { 0, value } }), from);
+    advanceMillis(20);
+    int before = receives;
+    comms->update();
+    return receives > before;
+}
+
+void test_in_order_packets_are_applied()
+{
+    for (uint16_t sequence = 0; sequence < 10; sequence++) {
+        TEST_ASSERT_TRUE(receive(sequence, sequence));
+        TEST_ASSERT_EQUAL_FLOAT(sequence, comms->getValue_xrp_motor(0));
+    }
+    XSWC::Stats stats = comms->getStats();
+    TEST_ASSERT_EQUAL(10, stats.packetsReceived);
+    TEST_ASSERT_EQUAL(0, stats.packetsLost);
+    TEST_ASSERT_EQUAL(0, stats.packetsDuplicated);
+    TEST_ASSERT_EQUAL(0, stats.packetsReordered);
+}
+
+void test_skipped_sequence_numbers_are_lost()
+{
+    receive(0, 0);
+    TEST_ASSERT_TRUE(receive(3, 3));
+    TEST_ASSERT_TRUE(receive(4, 4));
+    TEST_ASSERT_TRUE(receive(10, 10));
+    TEST_ASSERT_EQUAL(2 + 5, comms->getStats().packetsLost);
+    TEST_ASSERT_EQUAL_FLOAT(10, comms->getValue_xrp_motor(0));
+}
+
+void test_duplicate_is_ignored()
+{
+    receive(0, 0);
+    receive(1, 1);
+    TEST_ASSERT_FALSE(receive(1, 99));
+    TEST_ASSERT_FALSE(receive(0, 99));
+    TEST_ASSERT_EQUAL_FLOAT(1, comms->getValue_xrp_motor(0));
+    TEST_ASSERT_EQUAL(2, comms->getStats().packetsDuplicated);
+    TEST_ASSERT_EQUAL(0, comms->getStats().packetsReordered);
+}
+
+void test_late_packet_is_reordered_not_lost()
+{
+    receive(0, 0);
+    receive(2, 2);
+    TEST_ASSERT_EQUAL(1, comms->getStats().packetsLost);
+    TEST_ASSERT_FALSE(receive(1, 1)); // arrives late, motor 0 keeps the newer value
+    TEST_ASSERT_EQUAL_FLOAT(2, comms->getValue_xrp_motor(0));
+    XSWC::Stats stats = comms->getStats();
+    TEST_ASSERT_EQUAL(0, stats.packetsLost);
+    TEST_ASSERT_EQUAL(1, stats.packetsReordered);
+    TEST_ASSERT_EQUAL(0, stats.packetsDuplicated);
+    TEST_ASSERT_FALSE(receive(1, 1)); // the second copy is a duplicate
+    TEST_ASSERT_EQUAL(1, comms->getStats().packetsDuplicated);
+}
+
+void test_very_old_packet_is_reordered()
+{
+    receive(100, 100);
+    receive(200, 200);
+    TEST_ASSERT_FALSE(receive(150, 150)); // too far back for the window, it can't be told apart from a duplicate
+    TEST_ASSERT_EQUAL(1, comms->getStats().packetsReordered);
+    TEST_ASSERT_EQUAL_FLOAT(200, comms->getValue_xrp_motor(0));
+}
+
+void test_sequence_wraps_around()
+{
+    receive(65534, 1);
+    TEST_ASSERT_TRUE(receive(65535, 2));
+    TEST_ASSERT_TRUE(receive(0, 3));
+    TEST_ASSERT_TRUE(receive(1, 4));
+    TEST_ASSERT_FALSE(receive(65535, 5));
+    TEST_ASSERT_EQUAL_FLOAT(4, comms->getValue_xrp_motor(0));
+    TEST_ASSERT_EQUAL(0, comms->getStats().packetsLost);
+    TEST_ASSERT_EQUAL(1, comms->getStats().packetsDuplicated);
+}
+
+void test_restarted_sender_is_accepted()
+{
+    receive(5000, 1);
+    TEST_ASSERT_TRUE(receive(5000 - comms->SEQUENCE_RESYNC_DISTANCE - 1, 2));
+    TEST_ASSERT_EQUAL_FLOAT(2, comms->getValue_xrp_motor(0));
+    TEST_ASSERT_TRUE(receive(5000 - comms->SEQUENCE_RESYNC_DISTANCE, 3)); // counting continues from the new number
+    TEST_ASSERT_EQUAL(0, comms->getStats().packetsLost);
+}
+
+void test_new_remote_starts_its_own_count()
+{
+    receive(500, 1);
+    TEST_ASSERT_FALSE(receive(600, 2, IPAddress(127, 0, 0, 2))); // ignored while the first remote is connected
+    TEST_ASSERT_EQUAL(1, comms->getStats().packetsFromOtherRemotes);
+    advanceMillis(comms->TIMEOUT_MS);
+    comms->update();
+    TEST_ASSERT_TRUE(receive(3, 3, IPAddress(127, 0, 0, 2))); // lower than the old remote's numbers, but a new count
+    TEST_ASSERT_EQUAL_FLOAT(3, comms->getValue_xrp_motor(0));
+    TEST_ASSERT_EQUAL(0, comms->getStats().packetsLost);
+    TEST_ASSERT_EQUAL(0, comms->getStats().packetsReordered);
+}
+
+void test_queued_packets_are_tracked_in_order()
+{
+    // several packets read in the same update(), one of them late and one a duplicate
+    const uint16_t sequences[] = { 0, 2, 1, 3, 3, 5 };
+    for (uint16_t sequence : sequences) {
+        injectPacket(*udp, commandPacket(sequence, true, { { 0, sequence } }));
+    }
+    advanceMillis(20);
+    TEST_ASSERT_TRUE(comms->update());
+    TEST_ASSERT_EQUAL(1, receives);
+    TEST_ASSERT_EQUAL_FLOAT(5, comms->getValue_xrp_motor(0));
+    XSWC::Stats stats = comms->getStats();
+    TEST_ASSERT_EQUAL(6, stats.packetsReceived);
+    TEST_ASSERT_EQUAL(1, stats.packetsLost); // 4 never arrived
+    TEST_ASSERT_EQUAL(1, stats.packetsReordered);
+    TEST_ASSERT_EQUAL(1, stats.packetsDuplicated);
+}
+
+void setUp()
+{
+    comms = new XSWC();
+    udp = new MockUDP();
+    receives = 0;
+    beginTest(*comms, *udp, countReceive);
+}
+
+void tearDown()
+{
+    delete comms;
+    delete udp;
+}
+
+int main(int argc, char** argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_in_order_packets_are_applied);
+    RUN_TEST(test_skipped_sequence_numbers_are_lost);
+    RUN_TEST(test_duplicate_is_ignored);
+    RUN_TEST(test_late_packet_is_reordered_not_lost);
+    RUN_TEST(test_very_old_packet_is_reordered);
+    RUN_TEST(test_sequence_wraps_around);
+    RUN_TEST(test_restarted_sender_is_accepted);
+    RUN_TEST(test_new_remote_starts_its_own_count);
+    RUN_TEST(test_queued_packets_are_tracked_in_order);
+    return UNITY_END();
+}
@@ -0,0 +1,171 @@
+/*
+ * Telemetry that doesn't fit in MAX_DATAGRAM_SIZE is split into several datagrams,
+ * each with its own header and sequence number and only whole blocks.
+ */
+
+#include "../xswc_test.h"
+
+#include <set>
+
+typedef BasicXSWC<1000, 4000> LargeXSWC;
+
+static LargeXSWC* comms = nullptr;
+static MockUDP* udp = nullptr;
+static XSWC* defaultComms = nullptr; // BasicXSWC with the default buffer sizes
+static int encoders = 0;
+
+static void sendEncoders()
+{
+    for (int i = 0; i < encoders; i++) {
+        comms->sendValue_xrp_encoder(i, i * 10);
+    }
+}
+
+// connect and send one frame, returns the datagrams it was sent as
+static std::vector<MockUDP::Datagram> sendFrame()
+{
+    static uint16_t sequence = 0;
+    injectPacket(*udp, commandPacket(sequence++, true));
+    advanceMillis(comms->MIN_UPDATE_TIME_MS + 1);
+    udp->sent.clear();
+    comms->update();
+    return udp->sent;
+}
+
+// every encoder id found in the datagrams, failing if one is there twice
+static std::set<int> encoderIds(const std::vector<MockUDP::Datagram>& datagrams)
+{
+    std::set<int> ids;
+    for (const MockUDP::Datagram& datagram : datagrams) {
+        for (const SentBlock& block : blocksOf(datagram)) {
+            TEST_ASSERT_EQUAL(XRP_TAG_ENCODER, block.tag);
+            TEST_ASSERT_TRUE(ids.insert(block.id).second);
+        }
+    }
+    return ids;
+}
+
+void test_small_frame_is_one_datagram()
+{
+    encoders = 10;
+    std::vector<MockUDP::Datagram> sent = sendFrame();
+    TEST_ASSERT_EQUAL(1, sent.size());
+    TEST_ASSERT_EQUAL(3 + 10 * 15, sent[0].data.size());
+    TEST_ASSERT_EQUAL(0, comms->getStats().telemetryFramesSplit);
+}
+
+void test_large_frame_is_split()
+{
+    encoders = 150; // 2250 bytes of blocks
+    std::vector<MockUDP::Datagram> sent = sendFrame();
+    TEST_ASSERT_EQUAL(3, sent.size());
+    uint16_t first = sequenceOf(sent[0]);
+    for (size_t i = 0; i < sent.size(); i++) {
+        TEST_ASSERT_LESS_OR_EQUAL(comms->MAX_DATAGRAM_SIZE, sent[i].data.size());
+        TEST_ASSERT_EQUAL((uint16_t)(first + i), sequenceOf(sent[i]));
+        TEST_ASSERT_EQUAL(0, sent[i].data[2]); // control byte
+    }
+    TEST_ASSERT_EQUAL(150, encoderIds(sent).size());
+    LargeXSWC::Stats stats = comms->getStats();
+    TEST_ASSERT_EQUAL(1, stats.telemetryFramesSplit);
+    TEST_ASSERT_EQUAL(2, stats.telemetryExtraDatagrams);
+    TEST_ASSERT_EQUAL(0, stats.telemetryBlocksDropped);
+    TEST_ASSERT_EQUAL(3, stats.packetsSent);
+
+    // the next frame continues counting after the last datagram
+    std::vector<MockUDP::Datagram> next = sendFrame();
+    TEST_ASSERT_EQUAL((uint16_t)(first + 3), sequenceOf(next[0]));
+}
+
+void test_smaller_datagram_size()
+{
+    encoders = 20;
+    comms->MAX_DATAGRAM_SIZE = 3 + 4 * 15; // 4 blocks per datagram
+    std::vector<MockUDP::Datagram> sent = sendFrame();
+    TEST_ASSERT_EQUAL(5, sent.size());
+    for (const MockUDP::Datagram& datagram : sent) {
+        TEST_ASSERT_EQUAL(4, blocksOf(datagram).size());
+    }
+    TEST_ASSERT_EQUAL(20, encoderIds(sent).size());
+}
+
+void test_blocks_that_never_fit_are_dropped()
+{
+    encoders = 3;
+    comms->MAX_DATAGRAM_SIZE = 10; // smaller than a header and an encoder block
+    std::vector<MockUDP::Datagram> sent = sendFrame();
+    TEST_ASSERT_EQUAL(1, sent.size()); // the header still tells the remote the robot is there
+    TEST_ASSERT_EQUAL(3, sent[0].data.size());
+    TEST_ASSERT_EQUAL(3, comms->getStats().telemetryBlocksDropped);
+}
+
+void test_frame_needing_too_many_datagrams_is_cut()
+{
+    encoders = 200;
+    comms->MAX_DATAGRAM_SIZE = 3 + 10 * 15; // 20 datagrams would be needed
+    std::vector<MockUDP::Datagram> sent = sendFrame();
+    TEST_ASSERT_EQUAL(16, sent.size());
+    TEST_ASSERT_EQUAL(160, encoderIds(sent).size());
+    TEST_ASSERT_EQUAL(40, comms->getStats().telemetryBlocksDropped);
+}
+
+void test_subscribers_get_the_same_datagrams()
+{
+    encoders = 150;
+    TEST_ASSERT_TRUE(comms->addTelemetrySubscriber(IPAddress(127, 0, 0, 9), 3540));
+    std::vector<MockUDP::Datagram> sent = sendFrame();
+    TEST_ASSERT_EQUAL(6, sent.size());
+    for (size_t i = 0; i < sent.size(); i += 2) {
+        TEST_ASSERT_TRUE(sent[i].addr == IPAddress(127, 0, 0, 1));
+        TEST_ASSERT_TRUE(sent[i + 1].addr == IPAddress(127, 0, 0, 9));
+        TEST_ASSERT_TRUE(sent[i].data == sent[i + 1].data);
+    }
+    TEST_ASSERT_EQUAL(2, comms->getStats().telemetryExtraDatagrams); // counted once per frame, not per destination
+}
+
+void test_default_buffer_counts_blocks_that_dont_fit()
+{
+    MockUDP defaultUdp;
+    defaultComms = new XSWC();
+    beginTest(*defaultComms, defaultUdp, ignoreCallback, [] {
+        for (int i = 0; i < 100; i++) {
+            defaultComms->sendValue_xrp_encoder(i, i);
+        }
+    });
+    injectPacket(defaultUdp, commandPacket(0, true));
+    advanceMillis(defaultComms->MIN_UPDATE_TIME_MS + 1);
+    defaultComms->update();
+    TEST_ASSERT_EQUAL(1, defaultUdp.sent.size());
+    int blocks = blocksOf(defaultUdp.sent[0]).size();
+    TEST_ASSERT_EQUAL((1000 - 3) / 15, blocks); // the rest didn't fit in the buffer, so nothing has to be split
+    TEST_ASSERT_EQUAL(100 - blocks, defaultComms->getStats().telemetryBufferFull);
+    TEST_ASSERT_EQUAL(0, defaultComms->getStats().telemetryFramesSplit);
+}
+
+void setUp()
+{
+    comms = new LargeXSWC();
+    udp = new MockUDP();
+    beginTest(*comms, *udp, ignoreCallback, sendEncoders);
+}
+
+void tearDown()
+{
+    delete comms;
+    delete udp;
+    delete defaultComms;
+    defaultComms = nullptr;
+}
+
+int main(int argc, char** argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_small_frame_is_one_datagram);
+    RUN_TEST(test_large_frame_is_split);
+    RUN_TEST(test_smaller_datagram_size);
+    RUN_TEST(test_blocks_that_never_fit_are_dropped);
+    RUN_TEST(test_frame_needing_too_many_datagrams_is_cut);
+    RUN_TEST(test_subscribers_get_the_same_datagrams);
+    RUN_TEST(test_default_buffer_counts_blocks_that_dont_fit);
+    return UNITY_END();
+}
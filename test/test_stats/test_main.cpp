@@ -0,0 +1,230 @@
+/*
+ * The link counters from getStats(), and reportStats, which sends some of them on reserved analog and DIO ids.
+ */
+
+#include "../xswc_test.h"
+
+// a MockUDP whose endPacket() fails when asked to, like when the network stack is out of buffers
+class FlakyUDP : public MockUDP {
+public:
+    int endPacket() override
+    {
+        if (failNext) {
+            failNext = false;
+            return 0;
+        }
+        return MockUDP::endPacket();
+    }
+
+    bool failNext = false;
+};
+
+// lets a test set counters that would take too long to reach
+class CountingXSWC : public XSWC {
+public:
+    void setPacketsReceived(uint32_t packets)
+    {
+        stats.packetsReceived = packets;
+    }
+};
+
+typedef BasicXSWC<1000, 4000> LargeXSWC;
+
+static CountingXSWC* comms = nullptr;
+static LargeXSWC* largeComms = nullptr;
+static FlakyUDP* udp = nullptr;
+static uint16_t sequence = 0;
+
+// the value of a block with the tag and id, -1 if the datagram doesn't have it
+static float valueIn(const MockUDP::Datagram& datagram, uint8_t tag, uint8_t id)
+{
+    size_t index = 3;
+    for (const SentBlock& block : blocksOf(datagram)) {
+        if (block.tag == tag && block.id == id) {
+            const char* data = (const char*)datagram.data.data();
+            return tag == XRP_TAG_DIO ? data[index + 3] : networkToFloat(data, index + 3);
+        }
+        index += block.size;
+    }
+    return -1;
+}
+
+static void receive(const std::vector<uint8_t>& packet, IPAddress from = IPAddress(127, 0, 0, 1))
+{
+    injectPacket(*udp, packet, from);
+    advanceMillis(5);
+    comms->update();
+}
+
+// a command, then telemetry is sent, returns the datagram
+static MockUDP::Datagram sendOnce()
+{
+    injectPacket(*udp, commandPacket(sequence++, true));
+    advanceMillis(comms->MIN_UPDATE_TIME_MS + 1);
+    udp->sent.clear();
+    comms->update();
+    TEST_ASSERT_EQUAL(1, udp->sent.size());
+    return udp->sent[0];
+}
+
+// a command, then sending telemetry fails
+static void failOnce()
+{
+    udp->failNext = true;
+    injectPacket(*udp, commandPacket(sequence++, true));
+    advanceMillis(comms->MIN_UPDATE_TIME_MS + 1);
+    comms->update();
+}
+
+void test_received_packets_are_counted()
+{
+    receive(commandPacket(sequence++, true, { { 0, 1 } }));
+    std::vector<uint8_t> unknownTag = commandPacket(sequence++, true, { { 0, 1 } });
+    unknownTag.insert(unknownTag.end(), { 2, 0x7F, 0 });
+    receive(unknownTag);
+    std::vector<uint8_t> badSize = commandPacket(sequence++, true);
+    badSize.insert(badSize.end(), { 0, XRP_TAG_MOTOR });
+    receive(badSize);
+    receive({ 0, 1 }); // too short
+    receive(commandPacket(0, true), IPAddress(127, 0, 0, 2));
+    sequence += 2;
+    receive(commandPacket(sequence++, true));
+
+    XSWC::Stats stats = comms->getStats();
+    TEST_ASSERT_EQUAL(5, stats.packetsReceived);
+    TEST_ASSERT_EQUAL(10 + 13 + 5 + 2 + 3, stats.bytesReceived);
+    TEST_ASSERT_EQUAL(1, stats.parseUnknownTags);
+    TEST_ASSERT_EQUAL(1, stats.parseBadSize);
+    TEST_ASSERT_EQUAL(1, stats.parseShortPackets);
+    TEST_ASSERT_EQUAL(1, stats.packetsFromOtherRemotes);
+    TEST_ASSERT_EQUAL(2, stats.packetsLost);
+
+    comms->resetStats();
+    stats = comms->getStats();
+    TEST_ASSERT_EQUAL(0, stats.packetsReceived);
+    TEST_ASSERT_EQUAL(0, stats.bytesReceived);
+    TEST_ASSERT_EQUAL(0, stats.packetsLost);
+}
+
+void test_only_sent_bytes_are_counted()
+{
+    size_t bytes = 0;
+    for (int i = 0; i < 3; i++) {
+        bytes += sendOnce().data.size();
+    }
+    XSWC::Stats stats = comms->getStats();
+    TEST_ASSERT_EQUAL(3, stats.packetsSent);
+    TEST_ASSERT_EQUAL(bytes, stats.bytesSent);
+
+    failOnce();
+    stats = comms->getStats();
+    TEST_ASSERT_EQUAL(1, stats.telemetrySendFailures);
+    TEST_ASSERT_EQUAL(3, stats.packetsSent);
+    TEST_ASSERT_EQUAL(bytes, stats.bytesSent);
+}
+
+void test_only_sent_bytes_of_split_frames_are_counted()
+{
+    FlakyUDP largeUdp;
+    largeComms = new LargeXSWC();
+    LargeXSWC* large = largeComms;
+    beginTest(*large, largeUdp, ignoreCallback, [] {
+        for (int i = 0; i < 100; i++) {
+            largeComms->sendValue_xrp_encoder(i, i);
+        }
+    });
+    large->MAX_DATAGRAM_SIZE = 500;
+    injectPacket(largeUdp, commandPacket(0, true));
+    advanceMillis(large->MIN_UPDATE_TIME_MS + 1);
+    large->update();
+    size_t bytes = 0;
+    for (const MockUDP::Datagram& datagram : largeUdp.sent) {
+        bytes += datagram.data.size();
+    }
+    TEST_ASSERT_GREATER_THAN(1, largeUdp.sent.size());
+    TEST_ASSERT_EQUAL(bytes, large->getStats().bytesSent);
+
+    largeUdp.failNext = true; // the first datagram of the next frame
+    injectPacket(largeUdp, commandPacket(1, true));
+    advanceMillis(large->MIN_UPDATE_TIME_MS + 1);
+    largeUdp.sent.clear();
+    large->update();
+    for (const MockUDP::Datagram& datagram : largeUdp.sent) {
+        bytes += datagram.data.size();
+    }
+    TEST_ASSERT_EQUAL(bytes, large->getStats().bytesSent);
+}
+
+void test_report_stats_ids()
+{
+    comms->reportStats = true;
+    MockUDP::Datagram sent = sendOnce();
+    TEST_ASSERT_EQUAL_FLOAT(1, valueIn(sent, XRP_TAG_ANALOG, 12)); // packets received
+    TEST_ASSERT_EQUAL_FLOAT(0, valueIn(sent, XRP_TAG_ANALOG, 13)); // lost
+    TEST_ASSERT_EQUAL_FLOAT(0, valueIn(sent, XRP_TAG_ANALOG, 14)); // parse errors
+    TEST_ASSERT_EQUAL_FLOAT(0, valueIn(sent, XRP_TAG_ANALOG, 15)); // telemetry not sent
+    TEST_ASSERT_EQUAL(1, valueIn(sent, XRP_TAG_DIO, 15));
+
+    sequence += 2;
+    receive({ 0, 1 });
+    sent = sendOnce();
+    TEST_ASSERT_EQUAL_FLOAT(3, valueIn(sent, XRP_TAG_ANALOG, 12));
+    TEST_ASSERT_EQUAL_FLOAT(2, valueIn(sent, XRP_TAG_ANALOG, 13));
+    TEST_ASSERT_EQUAL_FLOAT(1, valueIn(sent, XRP_TAG_ANALOG, 14));
+    TEST_ASSERT_EQUAL(0, valueIn(sent, XRP_TAG_DIO, 15)); // something went wrong since the last send
+    TEST_ASSERT_EQUAL(1, valueIn(sendOnce(), XRP_TAG_DIO, 15));
+
+    failOnce();
+    sent = sendOnce();
+    TEST_ASSERT_EQUAL_FLOAT(1, valueIn(sent, XRP_TAG_ANALOG, 15));
+    TEST_ASSERT_EQUAL(0, valueIn(sent, XRP_TAG_DIO, 15));
+}
+
+void test_report_stats_other_ids()
+{
+    comms->reportStats = true;
+    comms->STATS_ANALOG_FIRST_ID = 4;
+    comms->STATS_DIO_ID = 2;
+    MockUDP::Datagram sent = sendOnce();
+    TEST_ASSERT_EQUAL_FLOAT(1, valueIn(sent, XRP_TAG_ANALOG, 4));
+    TEST_ASSERT_EQUAL_FLOAT(0, valueIn(sent, XRP_TAG_ANALOG, 7));
+    TEST_ASSERT_EQUAL(1, valueIn(sent, XRP_TAG_DIO, 2));
+    TEST_ASSERT_EQUAL_FLOAT(-1, valueIn(sent, XRP_TAG_ANALOG, 12));
+}
+
+void test_reported_counts_wrap_at_2_to_the_24()
+{
+    comms->reportStats = true;
+    comms->setPacketsReceived((1 << 24) - 2);
+    TEST_ASSERT_EQUAL_FLOAT((1 << 24) - 1, valueIn(sendOnce(), XRP_TAG_ANALOG, 12));
+    TEST_ASSERT_EQUAL_FLOAT(0, valueIn(sendOnce(), XRP_TAG_ANALOG, 12));
+    TEST_ASSERT_EQUAL_FLOAT(1, valueIn(sendOnce(), XRP_TAG_ANALOG, 12));
+    TEST_ASSERT_EQUAL((1 << 24) + 1, comms->getStats().packetsReceived); // getStats() doesn't wrap
+}
+
+void setUp()
+{
+    comms = new CountingXSWC();
+    udp = new FlakyUDP();
+    beginTest(*comms, *udp);
+}
+
+void tearDown()
+{
+    delete comms;
+    delete udp;
+    delete largeComms;
+    largeComms = nullptr;
+}
+
+int main(int argc, char** argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_received_packets_are_counted);
+    RUN_TEST(test_only_sent_bytes_are_counted);
+    RUN_TEST(test_only_sent_bytes_of_split_frames_are_counted);
+    RUN_TEST(test_report_stats_ids);
+    RUN_TEST(test_report_stats_other_ids);
+    RUN_TEST(test_reported_counts_wrap_at_2_to_the_24);
+    return UNITY_END();
+}
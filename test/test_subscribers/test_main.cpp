@@ -0,0 +1,157 @@
+/*
+ * Telemetry subscribers: each frame is sent to the remote and to every subscriber,
+ * and a subscriber that can't be reached doesn't change how telemetry is sent to the remote.
+ */
+
+#include "../xswc_test.h"
+
+// a MockUDP whose endPacket() fails for one address, like when a subscriber's network is down
+class UnreachableUDP : public MockUDP {
+public:
+    int beginPacket(IPAddress ip, uint16_t port) override
+    {
+        destination = ip;
+        return MockUDP::beginPacket(ip, port);
+    }
+
+    int endPacket() override
+    {
+        if (destination == unreachable) {
+            return 0;
+        }
+        return MockUDP::endPacket();
+    }
+
+    IPAddress destination;
+    IPAddress unreachable;
+};
+
+static const IPAddress remote(127, 0, 0, 1);
+static const IPAddress dashboard(127, 0, 0, 9);
+static const IPAddress logger(127, 0, 0, 10);
+
+static XSWC* comms = nullptr;
+static UnreachableUDP* udp = nullptr;
+static uint16_t sequence = 0;
+static float analog = 0;
+
+static void sendTelemetry()
+{
+    comms->sendValue_xrp_analog(0, analog);
+}
+
+// a command keeps the link up, then telemetry is sent, returns the datagrams
+static std::vector<MockUDP::Datagram> sendOnce()
+{
+    injectPacket(*udp, commandPacket(sequence++, true));
+    advanceMillis(comms->MIN_UPDATE_TIME_MS + 1);
+    udp->sent.clear();
+    comms->update();
+    return udp->sent;
+}
+
+void test_every_subscriber_gets_the_frame()
+{
+    TEST_ASSERT_TRUE(comms->addTelemetrySubscriber(dashboard, 3540));
+    TEST_ASSERT_TRUE(comms->addTelemetrySubscriber(logger, 3540));
+    TEST_ASSERT_FALSE(comms->addTelemetrySubscriber(logger, 3540)); // already added
+    std::vector<MockUDP::Datagram> sent = sendOnce();
+    TEST_ASSERT_EQUAL(3, sent.size());
+    TEST_ASSERT_TRUE(sent[0].addr == remote);
+    TEST_ASSERT_TRUE(sent[1].addr == dashboard);
+    TEST_ASSERT_TRUE(sent[2].addr == logger);
+    TEST_ASSERT_TRUE(sent[0].data == sent[1].data && sent[0].data == sent[2].data);
+
+    TEST_ASSERT_TRUE(comms->removeTelemetrySubscriber(dashboard, 3540));
+    TEST_ASSERT_EQUAL(1, comms->getTelemetrySubscriberCount());
+    TEST_ASSERT_EQUAL(2, sendOnce().size());
+}
+
+void test_subscriber_limit()
+{
+    for (int i = 0; i < 4; i++) {
+        TEST_ASSERT_TRUE(comms->addTelemetrySubscriber(IPAddress(127, 0, 0, 20 + i), 3540));
+    }
+    TEST_ASSERT_FALSE(comms->addTelemetrySubscriber(dashboard, 3540));
+}
+
+void test_remote_that_is_also_a_subscriber_gets_one_copy()
+{
+    TEST_ASSERT_TRUE(comms->addTelemetrySubscriber(remote, 3541));
+    TEST_ASSERT_EQUAL(1, sendOnce().size());
+}
+
+void test_unreachable_subscriber_is_counted_on_its_own()
+{
+    comms->deltaTelemetry = true;
+    comms->addTelemetrySubscriber(dashboard, 3540);
+    udp->unreachable = dashboard;
+    std::vector<MockUDP::Datagram> sent = sendOnce();
+    TEST_ASSERT_EQUAL(1, sent.size());
+    TEST_ASSERT_EQUAL(1, countBlocks(sent[0], XRP_TAG_ANALOG));
+    XSWC::Stats stats = comms->getStats();
+    TEST_ASSERT_EQUAL(1, stats.subscriberSendFailures);
+    TEST_ASSERT_EQUAL(0, stats.telemetrySendFailures);
+    TEST_ASSERT_EQUAL(1, stats.packetsSent);
+
+    // the remote got the value, so it isn't sent again
+    TEST_ASSERT_EQUAL(0, countBlocks(sendOnce()[0], XRP_TAG_ANALOG));
+}
+
+void test_unreachable_remote_resends()
+{
+    comms->deltaTelemetry = true;
+    comms->addTelemetrySubscriber(dashboard, 3540);
+    udp->unreachable = remote;
+    std::vector<MockUDP::Datagram> sent = sendOnce();
+    TEST_ASSERT_EQUAL(1, sent.size());
+    TEST_ASSERT_TRUE(sent[0].addr == dashboard);
+    TEST_ASSERT_EQUAL(1, comms->getStats().telemetrySendFailures);
+    TEST_ASSERT_EQUAL(0, comms->getStats().subscriberSendFailures);
+
+    udp->unreachable = IPAddress();
+    sent = sendOnce();
+    TEST_ASSERT_EQUAL(1, countBlocks(sent[0], XRP_TAG_ANALOG)); // unchanged, but the remote never got it
+}
+
+void test_unreachable_subscriber_doesnt_slow_telemetry()
+{
+    comms->adaptiveTelemetryRate = true;
+    comms->addTelemetrySubscriber(dashboard, 3540);
+    for (int i = 0; i < 20; i++) {
+        sendOnce();
+    }
+    unsigned long interval = comms->getTelemetryIntervalMs();
+    udp->unreachable = dashboard;
+    for (int i = 0; i < 20; i++) {
+        sendOnce();
+    }
+    TEST_ASSERT_EQUAL(interval, comms->getTelemetryIntervalMs());
+    TEST_ASSERT_EQUAL(20, comms->getStats().subscriberSendFailures);
+}
+
+void setUp()
+{
+    comms = new XSWC();
+    udp = new UnreachableUDP();
+    analog = 0;
+    beginTest(*comms, *udp, ignoreCallback, sendTelemetry);
+}
+
+void tearDown()
+{
+    delete comms;
+    delete udp;
+}
+
+int main(int argc, char** argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_every_subscriber_gets_the_frame);
+    RUN_TEST(test_subscriber_limit);
+    RUN_TEST(test_remote_that_is_also_a_subscriber_gets_one_copy);
+    RUN_TEST(test_unreachable_subscriber_is_counted_on_its_own);
+    RUN_TEST(test_unreachable_remote_resends);
+    RUN_TEST(test_unreachable_subscriber_doesnt_slow_telemetry);
+    return UNITY_END();
+}
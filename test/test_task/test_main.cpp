@@ -0,0 +1,231 @@
+/*
+ * The communication task started by beginTask(): it receives and sends on its own thread, update() only picks up
+ * the newest commands (running the callbacks and handlers on the caller's thread) and hands telemetry back.
+ * These tests use the real clock, because the task runs on its own.
+ */
+
+#include "../xswc_test.h"
+
+#include <mutex>
+#include <thread>
+
+// MockUDP is used from the task and from the test at the same time, so every access is locked
+class LockedUDP : public MockUDP {
+public:
+    void push(const std::vector<uint8_t>& packet)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        inject(packet.data(), packet.size());
+    }
+
+    // the datagrams sent so far, copied
+    std::vector<Datagram> sentDatagrams()
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        return sent;
+    }
+
+    int parsePacket() override
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        return MockUDP::parsePacket();
+    }
+    int beginPacket(IPAddress ip, uint16_t port) override
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        return MockUDP::beginPacket(ip, port);
+    }
+    size_t write(const uint8_t* buffer, size_t size) override
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        return MockUDP::write(buffer, size);
+    }
+    int endPacket() override
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        senderThread = std::this_thread::get_id();
+        if (failNext) {
+            failNext = false;
+            failures++;
+            return 0;
+        }
+        return MockUDP::endPacket();
+    }
+
+    bool failNext = false; // the next endPacket() fails, like when the network stack is out of buffers
+    int failures = 0;
+    std::thread::id senderThread;
+    std::mutex lock;
+};
+
+static XSWC* comms = nullptr;
+static LockedUDP* udp = nullptr;
+static int receives = 0;
+static float receivedMotor = 0;
+static float handlerMotor = 0;
+static float boundMotor = 0;
+static std::thread::id callbackThread;
+static std::thread::id handlerThread;
+
+static void onReceive()
+{
+    receives++;
+    receivedMotor = comms->getValue_xrp_motor(0);
+    callbackThread = std::this_thread::get_id();
+}
+
+static void onSend()
+{
+    comms->sendValue_xrp_analog(0, 1.5f);
+}
+
+static void onMotor(const xrp_motor_t& data, void* context)
+{
+    handlerMotor = data.value;
+    handlerThread = std::this_thread::get_id();
+}
+
+// call update() until done() is true, gives up after 2 seconds
+template <typename F>
+static bool updateUntil(F done)
+{
+    unsigned long start = millis();
+    while (!done()) {
+        if (millis() - start > 2000) {
+            return false;
+        }
+        comms->update();
+        delay(1);
+    }
+    return true;
+}
+
+static float analogIn(const MockUDP::Datagram& datagram, uint8_t id)
+{
+    size_t index = 3;
+    for (const SentBlock& block : blocksOf(datagram)) {
+        if (block.tag == XRP_TAG_ANALOG && block.id == id) {
+            return networkToFloat((const char*)datagram.data.data(), index + 3);
+        }
+        index += block.size;
+    }
+    return -1;
+}
+
+void test_commands_reach_update_and_handlers()
+{
+    TEST_ASSERT_TRUE(comms->beginTask());
+    TEST_ASSERT_TRUE(comms->isTaskRunning());
+    udp->push(commandPacket(0, true, { { 0, 0.25f }, { 1, -0.5f } }));
+    TEST_ASSERT_TRUE(updateUntil([] { return receives > 0; }));
+    TEST_ASSERT_EQUAL_FLOAT(0.25f, receivedMotor);
+    TEST_ASSERT_EQUAL_FLOAT(-0.5f, comms->getValue_xrp_motor(1));
+    TEST_ASSERT_TRUE(comms->isConnectedAndEnabled());
+    TEST_ASSERT_EQUAL_FLOAT(0.25f, handlerMotor);
+    TEST_ASSERT_EQUAL_FLOAT(-0.5f, boundMotor);
+    // callbacks and handlers run in update(), not in the task
+    TEST_ASSERT_TRUE(callbackThread == std::this_thread::get_id());
+    TEST_ASSERT_TRUE(handlerThread == std::this_thread::get_id());
+}
+
+void test_newest_commands_win()
+{
+    TEST_ASSERT_TRUE(comms->beginTask());
+    for (uint16_t sequence = 0; sequence < 20; sequence++) {
+        udp->push(commandPacket(sequence, true, { { 0, sequence / 20.0f } }));
+    }
+    TEST_ASSERT_TRUE(updateUntil([] { return comms->getValue_xrp_motor(0) == 19 / 20.0f; }));
+    udp->push(commandPacket(5, true, { { 0, 0 } })); // old, ignored by the task
+    udp->push(commandPacket(20, false, { { 0, 1 } }));
+    TEST_ASSERT_TRUE(updateUntil([] { return receivedMotor == 1; }));
+    TEST_ASSERT_FALSE(comms->isEnabled());
+    TEST_ASSERT_EQUAL(1, comms->getStats().packetsDuplicated + comms->getStats().packetsReordered);
+}
+
+void test_telemetry_is_sent_by_the_task()
+{
+    TEST_ASSERT_TRUE(comms->beginTask());
+    udp->push(commandPacket(0, true));
+    TEST_ASSERT_TRUE(updateUntil([] { return !udp->sentDatagrams().empty(); }));
+    std::vector<MockUDP::Datagram> sent = udp->sentDatagrams();
+    TEST_ASSERT_TRUE(sent[0].addr == IPAddress(127, 0, 0, 1));
+    TEST_ASSERT_EQUAL(3541, sent[0].port);
+    TEST_ASSERT_EQUAL_FLOAT(1.5f, analogIn(sent[0], 0));
+    udp->lock.lock();
+    std::thread::id senderThread = udp->senderThread;
+    udp->lock.unlock();
+    TEST_ASSERT_TRUE(senderThread != std::this_thread::get_id());
+}
+
+void test_block_is_resent_after_the_task_fails_to_send_it()
+{
+    comms->deltaTelemetry = true;
+    comms->TELEMETRY_KEYFRAME_INTERVAL = 1000; // only a failed send may bring the block back
+    TEST_ASSERT_TRUE(comms->beginTask());
+    udp->push(commandPacket(0, true));
+    // the value never changes, so after the first datagrams that have it, it's skipped
+    TEST_ASSERT_TRUE(updateUntil([] {
+        std::vector<MockUDP::Datagram> sent = udp->sentDatagrams();
+        return !sent.empty() && countBlocks(sent.back(), XRP_TAG_ANALOG) == 0;
+    }));
+    TEST_ASSERT_EQUAL_FLOAT(1.5f, analogIn(udp->sentDatagrams()[0], 0));
+
+    udp->lock.lock();
+    udp->failNext = true;
+    udp->lock.unlock();
+    size_t before = udp->sentDatagrams().size();
+    // the frame that wasn't delivered didn't have it either, so it can only come back because of the failure
+    TEST_ASSERT_TRUE(updateUntil([before] {
+        std::vector<MockUDP::Datagram> sent = udp->sentDatagrams();
+        return sent.size() > before && countBlocks(sent.back(), XRP_TAG_ANALOG) == 1;
+    }));
+    udp->lock.lock();
+    int failures = udp->failures;
+    udp->lock.unlock();
+    TEST_ASSERT_EQUAL(1, failures);
+    TEST_ASSERT_EQUAL_FLOAT(1.5f, analogIn(udp->sentDatagrams().back(), 0));
+    udp->push(commandPacket(1, true)); // the task's counters are copied for getStats() when a packet arrives
+    TEST_ASSERT_TRUE(updateUntil([] { return comms->getStats().telemetrySendFailures == 1; }));
+}
+
+void test_update_works_without_the_task_after_end_task()
+{
+    TEST_ASSERT_TRUE(comms->beginTask());
+    TEST_ASSERT_FALSE(comms->beginTask()); // already running
+    comms->endTask();
+    TEST_ASSERT_FALSE(comms->isTaskRunning());
+    udp->push(commandPacket(0, true, { { 0, 0.75f } }));
+    TEST_ASSERT_TRUE(comms->update());
+    TEST_ASSERT_EQUAL_FLOAT(0.75f, receivedMotor);
+}
+
+void setUp()
+{
+    comms = new XSWC();
+    udp = new LockedUDP();
+    receives = 0;
+    receivedMotor = handlerMotor = boundMotor = 0;
+    comms->setTransport(*udp);
+    TEST_ASSERT_TRUE(comms->begin(onReceive, onSend));
+    comms->MIN_UPDATE_TIME_MS = 1;
+    comms->onReceive_xrp_motor(0, onMotor);
+    comms->bind_xrp_motor(1, boundMotor);
+}
+
+void tearDown()
+{
+    comms->endTask();
+    delete comms;
+    delete udp;
+}
+
+int main(int argc, char** argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_commands_reach_update_and_handlers);
+    RUN_TEST(test_newest_commands_win);
+    RUN_TEST(test_telemetry_is_sent_by_the_task);
+    RUN_TEST(test_block_is_resent_after_the_task_fails_to_send_it);
+    RUN_TEST(test_update_works_without_the_task_after_end_task);
+    return UNITY_END();
+}
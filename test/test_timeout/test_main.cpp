@@ -0,0 +1,174 @@
+/*
+ * Link timeout: the received values are forgotten and onTimeout() is called once as soon as nothing arrived for
+ * getTimeoutMs(), and with adaptiveTimeout that time follows the measured time between packets.
+ */
+
+#include "../xswc_test.h"
+
+static XSWC* comms = nullptr;
+static MockUDP* udp = nullptr;
+static uint16_t sequence = 0;
+static int timeouts = 0;
+static bool connectedInCallback = true;
+static bool enabledInCallback = true;
+static float motorInCallback = -1;
+
+static void onTimeout()
+{
+    timeouts++;
+    connectedInCallback = comms->isConnected();
+    enabledInCallback = comms->isEnabled();
+    motorInCallback = comms->getValue_xrp_motor(0);
+}
+
+// call update() every millisecond for ms milliseconds
+static void runFor(unsigned long ms)
+{
+    for (unsigned long i = 0; i < ms; i++) {
+        advanceMillis(1);
+        comms->update();
+    }
+}
+
+// a packet every periodMs milliseconds, with update() called every millisecond in between
+static void receiveEvery(unsigned long periodMs, int packets)
+{
+    for (int i = 0; i < packets; i++) {
+        injectPacket(*udp, commandPacket(sequence++, true, { { 0, 0.5f } }));
+        comms->update();
+        runFor(periodMs);
+    }
+}
+
+// how long after the last packet the timeout callback is called
+static unsigned long millisUntilTimeout()
+{
+    int before = timeouts;
+    for (unsigned long ms = 1; ms <= 5000; ms++) {
+        advanceMillis(1);
+        comms->update();
+        if (timeouts > before) {
+            return ms;
+        }
+    }
+    return 0;
+}
+
+void test_timeout_forgets_values_and_calls_back_once()
+{
+    receiveEvery(20, 10);
+    TEST_ASSERT_TRUE(comms->isConnectedAndEnabled());
+    TEST_ASSERT_EQUAL_FLOAT(0.5f, comms->getValue_xrp_motor(0));
+    TEST_ASSERT_EQUAL(comms->TIMEOUT_MS, comms->getTimeoutMs());
+
+    TEST_ASSERT_EQUAL(comms->TIMEOUT_MS - 20, millisUntilTimeout()); // 20 ms already passed after the last packet
+    TEST_ASSERT_EQUAL(1, timeouts);
+    TEST_ASSERT_FALSE(connectedInCallback);
+    TEST_ASSERT_FALSE(enabledInCallback);
+    TEST_ASSERT_EQUAL_FLOAT(0, motorInCallback);
+    xrp_motor_t motor;
+    TEST_ASSERT_FALSE(comms->getData_xrp_motor(motor, 0));
+    TEST_ASSERT_EQUAL(1, comms->getStats().linkTimeouts);
+
+    runFor(3000);
+    TEST_ASSERT_EQUAL(1, timeouts);
+
+    receiveEvery(20, 1);
+    TEST_ASSERT_TRUE(comms->isConnectedAndEnabled());
+    TEST_ASSERT_EQUAL_FLOAT(0.5f, comms->getValue_xrp_motor(0));
+}
+
+void test_callback_comes_before_a_late_packet()
+{
+    receiveEvery(20, 1);
+    advanceMillis(2000); // update() wasn't called for a while, then a packet is waiting
+    injectPacket(*udp, commandPacket(sequence++, true, { { 0, 0.25f } }));
+    TEST_ASSERT_TRUE(comms->update());
+    TEST_ASSERT_EQUAL(1, timeouts);
+    TEST_ASSERT_EQUAL_FLOAT(0, motorInCallback);
+    TEST_ASSERT_EQUAL_FLOAT(0.25f, comms->getValue_xrp_motor(0));
+    TEST_ASSERT_TRUE(comms->isConnected());
+}
+
+void test_adaptive_timeout_follows_the_packet_rate()
+{
+    comms->adaptiveTimeout = true;
+    comms->MIN_TIMEOUT_MS = 20;
+    receiveEvery(10, 10);
+    TEST_ASSERT_EQUAL(comms->TIMEOUT_MS, comms->getTimeoutMs()); // not measured enough yet
+    receiveEvery(10, comms->ADAPTIVE_TIMEOUT_WINDOW);
+    unsigned long timeout = comms->getTimeoutMs();
+    TEST_ASSERT_GREATER_OR_EQUAL(30, timeout); // 3 times 10 ms
+    TEST_ASSERT_LESS_OR_EQUAL(35, timeout);
+
+    // the sender slows down a little, the timeout follows before it runs out
+    receiveEvery(25, 10);
+    TEST_ASSERT_EQUAL(0, timeouts);
+    TEST_ASSERT_GREATER_OR_EQUAL(75, comms->getTimeoutMs());
+
+    comms->adaptiveTimeout = false;
+    TEST_ASSERT_EQUAL(comms->TIMEOUT_MS, comms->getTimeoutMs());
+}
+
+void test_adaptive_timeout_detects_loss_sooner()
+{
+    comms->adaptiveTimeout = true;
+    receiveEvery(10, comms->ADAPTIVE_TIMEOUT_WINDOW + 1);
+    TEST_ASSERT_EQUAL(comms->MIN_TIMEOUT_MS, comms->getTimeoutMs());
+    TEST_ASSERT_EQUAL(comms->MIN_TIMEOUT_MS - 10, millisUntilTimeout());
+    TEST_ASSERT_FALSE(comms->isConnected());
+
+    // restarting the measurement doesn't bring the link back
+    runFor(comms->TIMEOUT_MS * 2);
+    TEST_ASSERT_FALSE(comms->isConnected());
+    TEST_ASSERT_EQUAL(1, timeouts);
+    TEST_ASSERT_EQUAL(1, comms->getStats().linkTimeouts);
+}
+
+void test_measurement_restarts_after_a_lost_link()
+{
+    comms->adaptiveTimeout = true;
+    receiveEvery(10, comms->ADAPTIVE_TIMEOUT_WINDOW + 1);
+    millisUntilTimeout();
+    TEST_ASSERT_EQUAL(comms->TIMEOUT_MS, comms->getTimeoutMs());
+
+    // the next remote sends much slower than the measured timeout
+    injectPacket(*udp, commandPacket(0, true), IPAddress(127, 0, 0, 2));
+    comms->update();
+    for (uint16_t i = 1; i < 20; i++) {
+        runFor(300);
+        injectPacket(*udp, commandPacket(i, true), IPAddress(127, 0, 0, 2));
+        comms->update();
+    }
+    TEST_ASSERT_EQUAL(1, timeouts);
+    TEST_ASSERT_TRUE(comms->isConnected());
+}
+
+void setUp()
+{
+    comms = new XSWC();
+    udp = new MockUDP();
+    udp->keepSent = false;
+    beginTest(*comms, *udp);
+    comms->onTimeout(onTimeout);
+    timeouts = 0;
+    connectedInCallback = enabledInCallback = true;
+    motorInCallback = -1;
+}
+
+void tearDown()
+{
+    delete comms;
+    delete udp;
+}
+
+int main(int argc, char** argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_timeout_forgets_values_and_calls_back_once);
+    RUN_TEST(test_callback_comes_before_a_late_packet);
+    RUN_TEST(test_adaptive_timeout_follows_the_packet_rate);
+    RUN_TEST(test_adaptive_timeout_detects_loss_sooner);
+    RUN_TEST(test_measurement_restarts_after_a_lost_link);
+    return UNITY_END();
+}
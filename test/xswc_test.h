@@ -0,0 +1,102 @@
+/*
+ * Helpers shared by the unit tests, run them with: pio test -e native
+ * The tests drive the library through MockUDP with a clock they move forward themselves,
+ * so nothing depends on the network or on how fast the computer is.
+ */
+#pragma once
+
+#include <xrp-style-wpilib-comms.h>
+
+#include <MockUdp.h>
+#include <initializer_list>
+#include <unity.h>
+#include <utility>
+#include <vector>
+
+static unsigned long testMicros = 1000000; // not 0, so nothing looks like it happened when the library started
+
+inline unsigned long testClockMillis()
+{
+    return testMicros / 1000;
+}
+
+inline unsigned long testClockMicros()
+{
+    return testMicros;
+}
+
+inline void advanceMillis(unsigned long ms)
+{
+    testMicros += ms * 1000;
+}
+
+inline void ignoreCallback()
+{
+}
+
+// use udp and the test clock, then begin() with callbacks that do nothing unless they're given
+template <typename Comms>
+inline void beginTest(Comms& comms, MockUDP& udp, void (*receiveCallback)(void) = ignoreCallback, void (*sendCallback)(void) = ignoreCallback)
+{
+    comms.setTransport(udp);
+    comms.setClock(testClockMillis, testClockMicros);
+    TEST_ASSERT_TRUE(comms.begin(receiveCallback, sendCallback));
+}
+
+// a packet like wpilib sends: sequence number, control byte with the enable bit, then a block for each motor
+inline std::vector<uint8_t> commandPacket(uint16_t sequence, bool enabled, std::initializer_list<std::pair<uint8_t, float>> motors = {})
+{
+    std::vector<uint8_t> packet(3);
+    uint16ToNetwork(sequence, (char*)packet.data());
+    packet[2] = enabled ? 1 : 0;
+    for (const std::pair<uint8_t, float>& motor : motors) {
+        size_t index = packet.size();
+        packet.resize(index + 7);
+        packet[index] = 6; // size, without the size byte
+        packet[index + 1] = XRP_TAG_MOTOR;
+        packet[index + 2] = motor.first;
+        floatToNetwork(motor.second, (char*)packet.data(), index + 3);
+    }
+    return packet;
+}
+
+inline void injectPacket(MockUDP& udp, const std::vector<uint8_t>& packet, IPAddress from = IPAddress(127, 0, 0, 1))
+{
+    udp.inject(packet.data(), packet.size(), from);
+}
+
+inline uint16_t sequenceOf(const MockUDP::Datagram& datagram)
+{
+    return networkToUInt16((const char*)datagram.data.data(), 0);
+}
+
+struct SentBlock {
+    uint8_t tag;
+    uint8_t id; // the first byte after the tag, for tags without an id this is part of the data
+    int size; // including the size byte
+};
+
+// the blocks of a datagram the library sent, checking that their sizes add up to the datagram's length
+inline std::vector<SentBlock> blocksOf(const MockUDP::Datagram& datagram)
+{
+    std::vector<SentBlock> blocks;
+    size_t index = 3;
+    while (index < datagram.data.size()) {
+        int size = datagram.data[index] + 1;
+        TEST_ASSERT_TRUE(size >= 3 && index + size <= datagram.data.size());
+        blocks.push_back({ datagram.data[index + 1], datagram.data[index + 2], size });
+        index += size;
+    }
+    return blocks;
+}
+
+inline int countBlocks(const MockUDP::Datagram& datagram, uint8_t tag)
+{
+    int count = 0;
+    for (const SentBlock& block : blocksOf(datagram)) {
+        if (block.tag == tag) {
+            count++;
+        }
+    }
+    return count;
+}